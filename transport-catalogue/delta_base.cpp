@@ -0,0 +1,155 @@
+#include "delta_base.h"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace tr_cat {
+namespace serialize {
+namespace delta {
+
+namespace {
+
+struct EdgeKey {
+    StopId from;
+    StopId to;
+    BusId bus;
+    uint32_t count;
+    uint64_t weight_bits;
+
+    bool operator==(const EdgeKey& other) const {
+        return from == other.from && to == other.to && bus == other.bus
+               && count == other.count && weight_bits == other.weight_bits;
+    }
+};
+
+class EdgeKeyHasher {
+public:
+    size_t operator() (const EdgeKey& key) const {
+        size_t hash = (static_cast<size_t>(key.from) << 32) ^ key.to;
+        hash = hash * 37 + ((static_cast<size_t>(key.bus) << 32) ^ key.count);
+        return hash * 37 + key.weight_bits;
+    }
+};
+
+uint64_t WeightBits(double weight) {
+    uint64_t bits;
+    std::memcpy(&bits, &weight, sizeof(bits));
+    return bits;
+}
+
+}//namespace
+
+std::vector<uint32_t> MatchStops(const aggregations::TransportCatalogue& catalog,
+                                 const aggregations::TransportCatalogue& parent_catalog) {
+    std::vector<uint32_t> stop_to_parent(catalog.GetStops().size(), NO_PARENT);
+    for (const Stop& stop : catalog.GetStops()) {
+        if (std::optional<const Stop*> parent_stop = parent_catalog.GetStopInfo(stop.name)) {
+            stop_to_parent[stop.id] = (*parent_stop)->id;
+        }
+    }
+    return stop_to_parent;
+}
+
+std::vector<uint32_t> InvertStops(const std::vector<uint32_t>& stop_to_parent, size_t parent_stop_count) {
+    std::vector<uint32_t> stop_from_parent(parent_stop_count, NO_PARENT);
+    for (size_t stop = 0; stop < stop_to_parent.size(); ++stop) {
+        if (stop_to_parent[stop] != NO_PARENT) {
+            stop_from_parent[stop_to_parent[stop]] = static_cast<uint32_t>(stop);
+        }
+    }
+    return stop_from_parent;
+}
+
+bool SameBus(const Bus& bus, const Bus& parent_bus, const std::vector<uint32_t>& stop_to_parent) {
+    if (bus.is_ring != parent_bus.is_ring || bus.stops.size() != parent_bus.stops.size()
+        || bus.unique_stops != parent_bus.unique_stops || bus.distance != parent_bus.distance
+        || bus.curvature != parent_bus.curvature) {
+        return false;
+    }
+    for (size_t i = 0; i < bus.stops.size(); ++i) {
+        if (stop_to_parent[bus.stops[i]] != parent_bus.stops[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<int32_t> MatchEdges(const aggregations::TransportCatalogue& catalog,
+                                router::TransportRouter& router,
+                                const aggregations::TransportCatalogue& parent_catalog,
+                                router::TransportRouter& parent_router,
+                                const std::vector<uint32_t>& stop_from_parent) {
+    //одинаковые рёбра потомка (кольцо проходит пару остановок дважды) неразличимы в ответах,
+    //поэтому берётся первое
+    const auto edges_info = router.GetEdges();
+    std::unordered_map<EdgeKey, int32_t, EdgeKeyHasher> edges_by_key;
+    edges_by_key.reserve(edges_info.size());
+    for (graph::EdgeId edge_id = 0; edge_id < edges_info.size(); ++edge_id) {
+        const graph::Edge<double>& edge = router.GetGraph().GetEdge(edge_id);
+        const router::EdgeInfo& info = edges_info.begin()[edge_id];
+        edges_by_key.emplace(EdgeKey{static_cast<StopId>(edge.from), static_cast<StopId>(edge.to),
+                                     info.bus, info.count, WeightBits(edge.weight)},
+                             static_cast<int32_t>(edge_id));
+    }
+
+    std::vector<uint32_t> bus_from_parent(parent_catalog.GetBuses().size(), NO_PARENT);
+    for (const Bus& parent_bus : parent_catalog.GetBuses()) {
+        if (std::optional<const Bus*> bus = catalog.GetBusInfo(parent_bus.name)) {
+            bus_from_parent[parent_bus.id] = (*bus)->id;
+        }
+    }
+
+    const auto parent_edges_info = parent_router.GetEdges();
+    std::vector<int32_t> edge_from_parent(parent_edges_info.size(), NO_MATCH);
+    for (graph::EdgeId edge_id = 0; edge_id < parent_edges_info.size(); ++edge_id) {
+        const graph::Edge<double>& edge = parent_router.GetGraph().GetEdge(edge_id);
+        const router::EdgeInfo& info = parent_edges_info.begin()[edge_id];
+        const uint32_t from = stop_from_parent.at(edge.from);
+        const uint32_t to = stop_from_parent.at(edge.to);
+        const uint32_t bus = bus_from_parent.at(info.bus);
+        if (from == NO_PARENT || to == NO_PARENT || bus == NO_PARENT) {
+            continue;
+        }
+        auto it = edges_by_key.find(EdgeKey{from, to, bus, info.count, WeightBits(edge.weight)});
+        if (it != edges_by_key.end()) {
+            edge_from_parent[edge_id] = it->second;
+        }
+    }
+    return edge_from_parent;
+}
+
+bool RemapRow(const graph::Router<double>& parent_routes,
+              graph::VertexId from,
+              const std::vector<uint32_t>& stop_to_parent,
+              const std::vector<int32_t>& edge_from_parent,
+              double* weights, int32_t* prev_edges) {
+    using Routes = graph::Router<double>;
+    const uint32_t parent_from = stop_to_parent.at(from);
+    if (parent_from == NO_PARENT) {
+        return false;
+    }
+    const size_t parent_vertex_count = parent_routes.GetVertexCount();
+    const double* parent_weights = parent_routes.GetWeights() + parent_from * parent_vertex_count;
+    const int32_t* parent_prev_edges = parent_routes.GetPrevEdges() + parent_from * parent_vertex_count;
+    for (size_t to = 0; to < stop_to_parent.size(); ++to) {
+        const uint32_t parent_to = stop_to_parent[to];
+        const int32_t parent_prev_edge = parent_to == NO_PARENT ? Routes::NO_ROUTE : parent_prev_edges[parent_to];
+        if (parent_prev_edge == Routes::NO_ROUTE) {
+            weights[to] = 0;
+            prev_edges[to] = Routes::NO_ROUTE;
+            continue;
+        }
+        weights[to] = parent_weights[parent_to];
+        if (parent_prev_edge == Routes::NO_EDGE) {
+            prev_edges[to] = Routes::NO_EDGE;
+            continue;
+        }
+        const int32_t edge = edge_from_parent.at(static_cast<size_t>(parent_prev_edge));
+        prev_edges[to] = edge == NO_MATCH ? UNRESOLVED : edge;
+    }
+    return true;
+}
+
+}//delta
+}//serialize
+}//tr_cat
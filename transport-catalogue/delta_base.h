@@ -0,0 +1,52 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace tr_cat {
+namespace serialize {
+namespace delta {
+
+//Дельта-база (секции SECTION_DELTA_* в transport_catalogue.proto) описывает потомка через родителя:
+//остановки и автобусы сопоставляются по названиям, рёбра графа - по остановкам, автобусу,
+//числу пролётов и весу. Строка таблицы маршрутов хранится в дельте, только если её нельзя
+//в точности восстановить из строки родителя через RemapRow, целиком или только изменённые ячейки.
+
+inline constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+inline constexpr int32_t NO_MATCH = -1;
+//prev_edge ячейки, маршрут в которой у родителя идёт по ребру без пары у потомка
+inline constexpr int32_t UNRESOLVED = -3;
+
+//id остановки родителя с тем же названием для каждой остановки потомка или NO_PARENT
+std::vector<uint32_t> MatchStops(const aggregations::TransportCatalogue& catalog,
+                                 const aggregations::TransportCatalogue& parent_catalog);
+
+//обратное соответствие: id остановки потомка для каждой остановки родителя или NO_PARENT
+std::vector<uint32_t> InvertStops(const std::vector<uint32_t>& stop_to_parent, size_t parent_stop_count);
+
+//автобус потомка совпадает с автобусом родителя: те же остановки по порядку и та же статистика
+bool SameBus(const Bus& bus, const Bus& parent_bus, const std::vector<uint32_t>& stop_to_parent);
+
+//ребро потомка для каждого ребра родителя или NO_MATCH
+std::vector<int32_t> MatchEdges(const aggregations::TransportCatalogue& catalog,
+                                router::TransportRouter& router,
+                                const aggregations::TransportCatalogue& parent_catalog,
+                                router::TransportRouter& parent_router,
+                                const std::vector<uint32_t>& stop_from_parent);
+
+//строка from потомка по строке родителя: маршруты в новые остановки отсутствуют,
+//рёбра заменяются сопоставленными, ячейки с рёбрами без пары - UNRESOLVED;
+//false, если from - новая остановка и строки у родителя нет
+bool RemapRow(const graph::Router<double>& parent_routes,
+              graph::VertexId from,
+              const std::vector<uint32_t>& stop_to_parent,
+              const std::vector<int32_t>& edge_from_parent,
+              double* weights, int32_t* prev_edges);
+
+}//delta
+}//serialize
+}//tr_cat
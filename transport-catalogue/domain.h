@@ -3,29 +3,100 @@
 #include "geo.h"
 #include "graph.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string>
 #include <vector>    
-#include <set>
 
 namespace tr_cat {
 
 const double INNACURACY = 1e-6;
 
-struct Stop;
+//плотные идентификаторы: порядковый номер остановки/автобуса при добавлении в каталог
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+//итератор по полному маршруту: для некольцевого после конечной остановки
+//идёт обратный путь, который не хранится, а вычисляется по индексу
+class RouteIterator {
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = StopId;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const StopId*;
+    using reference = const StopId&;
+
+    RouteIterator(const std::vector<StopId>& stops, size_t pos)
+    :stops_(&stops), pos_(pos) {}
+
+    reference operator*() const {
+        const size_t size = stops_->size();
+        return (*stops_)[pos_ < size ? pos_ : 2 * size - 2 - pos_];
+    }
+    reference operator[](difference_type n) const {return *(*this + n);}
+
+    RouteIterator& operator++() {++pos_; return *this;}
+    RouteIterator& operator--() {--pos_; return *this;}
+    RouteIterator operator++(int) {RouteIterator tmp = *this; ++pos_; return tmp;}
+    RouteIterator operator--(int) {RouteIterator tmp = *this; --pos_; return tmp;}
+    RouteIterator& operator+=(difference_type n) {pos_ += n; return *this;}
+    RouteIterator& operator-=(difference_type n) {pos_ -= n; return *this;}
+    RouteIterator operator+(difference_type n) const {return RouteIterator(*stops_, pos_ + n);}
+    RouteIterator operator-(difference_type n) const {return RouteIterator(*stops_, pos_ - n);}
+    difference_type operator-(const RouteIterator& other) const {
+        return static_cast<difference_type>(pos_) - static_cast<difference_type>(other.pos_);
+    }
+
+    bool operator==(const RouteIterator& other) const {return pos_ == other.pos_;}
+    bool operator!=(const RouteIterator& other) const {return pos_ != other.pos_;}
+    bool operator<(const RouteIterator& other) const {return pos_ < other.pos_;}
+    bool operator>(const RouteIterator& other) const {return pos_ > other.pos_;}
+    bool operator<=(const RouteIterator& other) const {return pos_ <= other.pos_;}
+    bool operator>=(const RouteIterator& other) const {return pos_ >= other.pos_;}
+    friend RouteIterator operator+(difference_type n, const RouteIterator& it) {return it + n;}
+
+private:
+    const std::vector<StopId>* stops_;
+    size_t pos_;
+};
+
 struct Bus {
+    BusId id = 0;
     std::string name;
-    std::vector<Stop*> stops;
+    std::vector<StopId> stops; //как заданы во входных данных, для некольцевого - только путь туда
     int unique_stops = 0;
     int distance = 0;
     double curvature = 0;
     bool is_ring = false;
+
+    //количество остановок на полном маршруте, с учётом обратного пути
+    size_t GetStopCount() const {
+        if (is_ring || stops.empty()) {
+            return stops.size();
+        }
+        return stops.size() * 2 - 1;
+    }
+
+    router::ranges::Range<RouteIterator> GetRoute() const {
+        return {RouteIterator(stops, 0), RouteIterator(stops, GetStopCount())};
+    }
 };
 
 struct Stop {
+    StopId id = 0;
     std::string name;
-    geo::Coordinates coordinates = {0, 0};
-    std::set<std::string_view> buses;
-    graph::VertexId vertex_id;
+    geo::FixedCoordinates coordinates;
+    geo::UnitVector unit_vector; //вычисляется один раз при добавлении остановки
+
+    geo::Coordinates GetCoordinates() const {return coordinates.ToDegrees();}
 };
 
+inline double ComputeDistance(const Stop& from, const Stop& to) {
+    if (from.coordinates == to.coordinates) {
+        return 0;
+    }
+    return geo::ComputeDistance(from.unit_vector, to.unit_vector);
+}
+
 } //tr_cat
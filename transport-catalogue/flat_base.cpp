@@ -0,0 +1,378 @@
+#include "flat_base.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TR_CAT_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tr_cat {
+namespace serialize {
+
+uint64_t HashBytes(uint64_t hash, const char* data, size_t size) {
+    constexpr uint64_t MULTIPLIER = 0x9e3779b97f4a7c15;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * MULTIPLIER;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * MULTIPLIER;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+namespace flat {
+
+using namespace std::string_literals;
+
+static_assert(std::is_trivially_copyable_v<graph::Edge<double>>);
+static_assert(std::is_trivially_copyable_v<router::EdgeInfo>);
+
+//-----------------------------------MappedFile------------------------------------------
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+#ifdef TR_CAT_HAS_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open base file "s + path.string());
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Can't read base file "s + path.string());
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Can't map base file "s + path.string());
+    }
+    data_ = static_cast<const char*>(mapped);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("Can't open base file "s + path.string());
+    }
+    size_ = static_cast<size_t>(in.tellg());
+    buffer_ = std::make_unique<char[]>(size_);
+    in.seekg(0);
+    in.read(buffer_.get(), static_cast<std::streamsize>(size_));
+    data_ = buffer_.get();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef TR_CAT_HAS_MMAP
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+bool IsFlatBase(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(MAGIC)] = {};
+    in.read(magic, sizeof(magic));
+    return in && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+//-----------------------------------Write------------------------------------------------
+
+namespace {
+
+uint64_t AlignUp(uint64_t value) {
+    return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+uint32_t CheckedU32(size_t value) {
+    if (value > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Base is too large for flat format"s);
+    }
+    return static_cast<uint32_t>(value);
+}
+
+struct PendingSection {
+    Section kind;
+    const void* data;
+    uint64_t size;
+};
+
+template <typename T>
+PendingSection MakeSection(Section kind, const T* data, size_t count) {
+    return {kind, data, count * sizeof(T)};
+}
+
+} // namespace
+
+void WriteBase(const std::filesystem::path& path,
+               const aggregations::TransportCatalogue& catalog,
+               const transport_catalog_serialize::RenderSettings& render_settings,
+               std::string_view rendered_map,
+               router::TransportRouter& router) {
+    std::string strings;
+    auto add_string = [&strings](std::string_view str) {
+        const uint32_t offset = CheckedU32(strings.size());
+        strings.append(str);
+        return offset;
+    };
+
+    std::vector<StopRecord> stops;
+    stops.reserve(catalog.GetStops().size());
+    for (const Stop& stop : catalog.GetStops()) {
+        stops.push_back({add_string(stop.name), CheckedU32(stop.name.size()),
+                         stop.coordinates.lat, stop.coordinates.lng});
+    }
+
+    std::vector<BusRecord> buses;
+    std::vector<StopId> bus_stops;
+    buses.reserve(catalog.GetBuses().size());
+    for (const Bus& bus : catalog.GetBuses()) {
+        buses.push_back({add_string(bus.name), CheckedU32(bus.name.size()),
+                         CheckedU32(bus_stops.size()), CheckedU32(bus.stops.size()), bus.is_ring,
+                         CheckedU32(bus.unique_stops), bus.distance, 0, bus.curvature});
+        bus_stops.insert(bus_stops.end(), bus.stops.begin(), bus.stops.end());
+    }
+
+    std::vector<DistanceRecord> distances;
+    distances.reserve(catalog.GetDistances().size());
+    for (const auto& [key, value] : catalog.GetDistances()) {
+        distances.push_back({key.first, key.second, value});
+    }
+
+    const std::string render_settings_bytes = render_settings.SerializeAsString();
+
+    const graph::Router<double>& routes = *router.GetRouter();
+    const RoutingRecord routing{router.GetSettings().bus_wait_time, router.GetSettings().bus_velocity,
+                                routes.GetVertexCount()};
+    const size_t cells_count = routes.GetVertexCount() * routes.GetVertexCount();
+    const auto edges = router.GetGraph().GetEdges();
+    const auto edges_info = router.GetEdges();
+
+    const std::vector<PendingSection> sections = {
+        MakeSection(Section::STRINGS, strings.data(), strings.size()),
+        MakeSection(Section::STOPS, stops.data(), stops.size()),
+        MakeSection(Section::BUSES, buses.data(), buses.size()),
+        MakeSection(Section::BUS_STOPS, bus_stops.data(), bus_stops.size()),
+        MakeSection(Section::DISTANCES, distances.data(), distances.size()),
+        MakeSection(Section::RENDER_SETTINGS, render_settings_bytes.data(), render_settings_bytes.size()),
+        MakeSection(Section::RENDERED_MAP, rendered_map.data(), rendered_map.size()),
+        MakeSection(Section::ROUTING, &routing, 1),
+        MakeSection(Section::EDGES, edges.begin(), edges.size()),
+        MakeSection(Section::EDGE_INFO, edges_info.begin(), edges_info.size()),
+        MakeSection(Section::ROUTE_WEIGHTS, routes.GetWeights(), cells_count),
+        MakeSection(Section::ROUTE_PREV_EDGES, routes.GetPrevEdges(), cells_count),
+    };
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.endian_mark = ENDIAN_MARK;
+    header.size_t_size = sizeof(size_t);
+    header.section_count = static_cast<uint32_t>(sections.size());
+    header.content_hash = CONTENT_HASH_SEED;
+    for (const PendingSection& section : sections) {
+        header.content_hash = HashBytes(header.content_hash ^ static_cast<uint64_t>(section.kind),
+                                        static_cast<const char*>(section.data), section.size);
+    }
+
+    std::vector<SectionEntry> entries;
+    entries.reserve(sections.size());
+    uint64_t offset = AlignUp(sizeof(Header) + sections.size() * sizeof(SectionEntry));
+    for (const PendingSection& section : sections) {
+        entries.push_back({static_cast<uint32_t>(section.kind), 0, offset, section.size});
+        offset = AlignUp(offset + section.size);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Can't create base file "s + path.string());
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(SectionEntry)));
+    uint64_t written = sizeof(Header) + entries.size() * sizeof(SectionEntry);
+    const char padding[ALIGNMENT] = {};
+    for (size_t i = 0; i < sections.size(); ++i) {
+        out.write(padding, static_cast<std::streamsize>(entries[i].offset - written));
+        out.write(static_cast<const char*>(sections[i].data), static_cast<std::streamsize>(sections[i].size));
+        written = entries[i].offset + sections[i].size;
+    }
+    if (!out) {
+        throw std::runtime_error("Can't write base file "s + path.string());
+    }
+}
+
+//-----------------------------------Read-------------------------------------------------
+
+namespace {
+
+class BaseView {
+public:
+    explicit BaseView(const MappedFile& file)
+        : file_(file) {
+        if (file.size() < sizeof(Header)) {
+            throw std::runtime_error("Flat base: file is too small"s);
+        }
+        Header header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("Flat base: wrong magic"s);
+        }
+        if (header.version != VERSION) {
+            throw std::runtime_error("Flat base: unsupported version "s + std::to_string(header.version));
+        }
+        if (header.endian_mark != ENDIAN_MARK || header.size_t_size != sizeof(size_t)) {
+            throw std::runtime_error("Flat base: written on incompatible platform"s);
+        }
+        if (header.section_count > (file.size() - sizeof(Header)) / sizeof(SectionEntry)) {
+            throw std::runtime_error("Flat base: broken section table"s);
+        }
+        content_hash_ = header.content_hash;
+        entries_.resize(header.section_count);
+        std::memcpy(entries_.data(), file.data() + sizeof(Header), entries_.size() * sizeof(SectionEntry));
+        for (const SectionEntry& entry : entries_) {
+            if (entry.offset % ALIGNMENT != 0 || entry.offset > file.size()
+                || entry.size > file.size() - entry.offset) {
+                throw std::runtime_error("Flat base: section out of file"s);
+            }
+        }
+    }
+
+    template <typename T>
+    ::router::ranges::Range<const T*> Get(Section kind) const {
+        for (const SectionEntry& entry : entries_) {
+            if (entry.kind == static_cast<uint32_t>(kind)) {
+                if (entry.size % sizeof(T) != 0) {
+                    throw std::runtime_error("Flat base: broken section "s + std::to_string(entry.kind));
+                }
+                const T* begin = reinterpret_cast<const T*>(file_.data() + entry.offset);
+                return {begin, begin + entry.size / sizeof(T)};
+            }
+        }
+        throw std::runtime_error("Flat base: no section "s + std::to_string(static_cast<uint32_t>(kind)));
+    }
+
+    uint64_t GetContentHash() const {return content_hash_;}
+
+private:
+    const MappedFile& file_;
+    uint64_t content_hash_;
+    std::vector<SectionEntry> entries_;
+};
+
+void CheckRange(uint64_t offset, uint64_t size, uint64_t limit) {
+    if (offset > limit || size > limit - offset) {
+        throw std::runtime_error("Flat base: record out of section"s);
+    }
+}
+
+} // namespace
+
+std::unique_ptr<MappedFile> ReadBase(const std::filesystem::path& path,
+                                     aggregations::TransportCatalogue& catalog,
+                                     transport_catalog_serialize::RenderSettings& render_settings,
+                                     std::string& rendered_map,
+                                     router::TransportRouter& router,
+                                     uint64_t& content_hash) {
+    auto file = std::make_unique<MappedFile>(path);
+    const BaseView base(*file);
+    content_hash = base.GetContentHash();
+
+    //------------catalog-----------------
+    const auto strings = base.Get<char>(Section::STRINGS);
+    auto get_name = [&strings](uint32_t offset, uint32_t size) {
+        CheckRange(offset, size, strings.size());
+        return std::string_view(strings.begin() + offset, size);
+    };
+    const auto stops = base.Get<StopRecord>(Section::STOPS);
+    for (const StopRecord& stop : stops) {
+        catalog.AddStop(get_name(stop.name_offset, stop.name_size),
+                        geo::FixedCoordinates{stop.latitude, stop.longitude});
+    }
+    for (const DistanceRecord& distance : base.Get<DistanceRecord>(Section::DISTANCES)) {
+        CheckRange(distance.from, 1, stops.size());
+        CheckRange(distance.to, 1, stops.size());
+        catalog.AddDistance(distance.from, distance.to, distance.distance);
+    }
+    const auto bus_stops = base.Get<StopId>(Section::BUS_STOPS);
+    for (const BusRecord& bus : base.Get<BusRecord>(Section::BUSES)) {
+        CheckRange(bus.stops_offset, bus.stops_count, bus_stops.size());
+        for (uint32_t i = 0; i < bus.stops_count; ++i) {
+            CheckRange(bus_stops.begin()[bus.stops_offset + i], 1, stops.size());
+        }
+        Bus bus_in;
+        bus_in.id = static_cast<BusId>(catalog.GetBuses().size());
+        bus_in.name = get_name(bus.name_offset, bus.name_size);
+        bus_in.stops.assign(bus_stops.begin() + bus.stops_offset,
+                            bus_stops.begin() + bus.stops_offset + bus.stops_count);
+        bus_in.unique_stops = static_cast<int>(bus.unique_stops);
+        bus_in.distance = bus.distance;
+        bus_in.curvature = bus.curvature;
+        bus_in.is_ring = bus.is_ring != 0;
+        catalog.AddBus(std::move(bus_in));
+    }
+    //статистика маршрутов хранится в базе
+    catalog.Freeze(false);
+
+    //------------render settings---------
+    const auto render_bytes = base.Get<char>(Section::RENDER_SETTINGS);
+    if (!render_settings.ParseFromArray(render_bytes.begin(), static_cast<int>(render_bytes.size()))) {
+        throw std::runtime_error("Flat base: broken render settings"s);
+    }
+    const auto rendered_map_bytes = base.Get<char>(Section::RENDERED_MAP);
+    rendered_map.assign(rendered_map_bytes.begin(), rendered_map_bytes.end());
+
+    //------------router------------------
+    const auto routing = base.Get<RoutingRecord>(Section::ROUTING);
+    if (routing.size() != 1) {
+        throw std::runtime_error("Flat base: broken routing section"s);
+    }
+    const RoutingRecord& routing_record = *routing.begin();
+    router.GetSettingsRef() = {routing_record.bus_wait_time, routing_record.bus_velocity};
+
+    const uint64_t vertex_count = routing_record.vertex_count;
+    const auto edges = base.Get<graph::Edge<double>>(Section::EDGES);
+    const auto edges_info = base.Get<router::EdgeInfo>(Section::EDGE_INFO);
+    const auto weights = base.Get<double>(Section::ROUTE_WEIGHTS);
+    const auto prev_edges = base.Get<int32_t>(Section::ROUTE_PREV_EDGES);
+    if (vertex_count != catalog.GetVertexCount() || edges.size() != edges_info.size()
+        || weights.size() != vertex_count * vertex_count || prev_edges.size() != weights.size()) {
+        throw std::runtime_error("Flat base: routing data doesn't match catalog"s);
+    }
+    //рёбра и их описания проверяются один раз здесь, дальше они используются без проверок.
+    //Таблица маршрутов не просматривается целиком, её значения проверяет Router::BuildRoute
+    for (const graph::Edge<double>& edge : edges) {
+        if (edge.from >= vertex_count || edge.to >= vertex_count) {
+            throw std::runtime_error("Flat base: edge out of graph"s);
+        }
+    }
+    for (const router::EdgeInfo& info : edges_info) {
+        if (info.stop >= catalog.GetStops().size() || info.bus >= catalog.GetBuses().size()) {
+            throw std::runtime_error("Flat base: edge info out of catalog"s);
+        }
+    }
+    router.GetGraphRef().SetVertexCount(vertex_count);
+    router.GetGraphRef().AttachEdges(edges.begin(), edges.size());
+    router.AttachEdges(edges_info.begin(), edges_info.size());
+    router.GetRouterRef() = std::make_unique<graph::Router<double>>(router.GetGraphRef(),
+                                                                    weights.begin(), prev_edges.begin());
+    return file;
+}
+
+}//flat
+}//serialize
+}//tr_cat
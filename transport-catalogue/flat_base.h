@@ -0,0 +1,131 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <map_renderer.pb.h>
+
+namespace tr_cat {
+namespace serialize {
+
+inline constexpr uint64_t CONTENT_HASH_SEED = 0xcbf29ce484222325;
+//хэш содержимого базы: не криптографический, только чтобы отличить одну базу от другой
+uint64_t HashBytes(uint64_t hash, const char* data, size_t size);
+
+namespace flat {
+
+//Плоский формат базы: заголовок, таблица секций и сами секции, выровненные по ALIGNMENT.
+//Каждая секция - массив записей одного POD-типа, поэтому process_requests отображает файл
+//в память и работает с рёбрами графа и таблицей маршрутов прямо в нём, без разбора.
+//При чтении проверяется только структура файла (размеры и границы секций), не содержимое.
+
+inline constexpr char MAGIC[8] = {'T', 'C', 'F', 'L', 'A', 'T', 'B', '1'};
+inline constexpr uint32_t VERSION = 4;
+inline constexpr uint32_t ENDIAN_MARK = 0x01020304;
+inline constexpr uint64_t ALIGNMENT = 64;
+
+enum class Section : uint32_t {
+    STRINGS = 1,        //char[]: названия остановок и автобусов подряд
+    STOPS = 2,          //StopRecord[], индекс - StopId
+    BUSES = 3,          //BusRecord[], индекс - BusId
+    BUS_STOPS = 4,      //StopId[]: остановки всех автобусов подряд
+    DISTANCES = 5,      //DistanceRecord[]
+    RENDER_SETTINGS = 6,//сообщение RenderSettings из map_renderer.proto
+    RENDERED_MAP = 12,  //char[]: SVG карты, нарисованной в make_base
+    ROUTING = 7,        //RoutingRecord
+    EDGES = 8,          //graph::Edge<double>[], индекс - EdgeId
+    EDGE_INFO = 9,      //router::EdgeInfo[], индекс - EdgeId
+    ROUTE_WEIGHTS = 10, //double[vertex_count * vertex_count]
+    ROUTE_PREV_EDGES = 11, //int32_t[vertex_count * vertex_count]
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_mark;
+    uint32_t size_t_size; //рёбра графа хранятся как graph::Edge<double>, его размер зависит от size_t
+    uint32_t section_count;
+    //хэш секций, посчитанный в WriteBase: по нему кэш маршрутов узнаёт свою базу, не читая файл
+    uint64_t content_hash;
+};
+
+struct SectionEntry {
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct StopRecord {
+    uint32_t name_offset;
+    uint32_t name_size;
+    int32_t latitude;
+    int32_t longitude;
+};
+
+struct BusRecord {
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t stops_offset;
+    uint32_t stops_count;
+    uint32_t is_ring;
+    //статистика маршрута, посчитанная в make_base
+    uint32_t unique_stops;
+    int32_t distance;
+    uint32_t reserved;
+    double curvature;
+};
+
+struct DistanceRecord {
+    StopId from;
+    StopId to;
+    int32_t distance;
+};
+
+struct RoutingRecord {
+    uint32_t bus_wait_time;
+    uint32_t bus_velocity;
+    uint64_t vertex_count;
+};
+
+//файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* data() const {return data_;}
+    size_t size() const {return size_;}
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::unique_ptr<char[]> buffer_; //если mmap недоступен, файл читается целиком
+};
+
+bool IsFlatBase(const std::filesystem::path& path);
+
+void WriteBase(const std::filesystem::path& path,
+               const aggregations::TransportCatalogue& catalog,
+               const transport_catalog_serialize::RenderSettings& render_settings,
+               std::string_view rendered_map,
+               router::TransportRouter& router);
+
+//заполняет каталог и настройки, граф и таблица маршрутов ссылаются на отображённый файл,
+//поэтому он должен жить, пока используется router
+std::unique_ptr<MappedFile> ReadBase(const std::filesystem::path& path,
+                                     aggregations::TransportCatalogue& catalog,
+                                     transport_catalog_serialize::RenderSettings& render_settings,
+                                     std::string& rendered_map,
+                                     router::TransportRouter& router,
+                                     uint64_t& content_hash);
+
+}//flat
+}//serialize
+}//tr_cat
@@ -0,0 +1,153 @@
+#include "geo.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TR_CAT_GEO_X86_64
+#include <immintrin.h>
+#endif
+
+namespace tr_cat {
+namespace geo {
+
+namespace {
+
+//ряд Тейлора asin(x) = x * (c[0] + c[1] * x^2 + c[2] * x^4 + ...), c[k] = c[k-1] * (2k-1)^2 / (2k * (2k+1))
+//аргумент всегда приводится к |x| <= 0.5, для 17 членов остаток меньше 2e-13 от значения
+constexpr int ASIN_TERMS = 17;
+
+struct AsinSeries {
+    double c[ASIN_TERMS] = {};
+    constexpr AsinSeries() {
+        c[0] = 1;
+        for (int k = 1; k < ASIN_TERMS; ++k) {
+            c[k] = c[k - 1] * (2. * k - 1) * (2. * k - 1) / ((2. * k) * (2. * k + 1));
+        }
+    }
+};
+
+constexpr AsinSeries ASIN_SERIES;
+constexpr double HALF_PI = 1.57079632679489661923;
+//размер блока, в котором сначала считаются квадраты хорд, а потом расстояния
+constexpr size_t BLOCK_SIZE = 256;
+
+//все варианты ниже выполняют одни и те же операции в одном порядке и без FMA,
+//поэтому дают одинаковый результат до бита
+
+double SquaredChord(const UnitVector& from, const UnitVector& to) {
+    const double dx = from.x - to.x;
+    const double dy = from.y - to.y;
+    const double dz = from.z - to.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+double ChordToDistance(double squared_chord) {
+    //h = sin(theta / 2); при h > 0.5: asin(h) = pi / 2 - 2 * asin(sqrt((1 - h) / 2))
+    const double h = std::min(std::sqrt(squared_chord) * 0.5, 1.0);
+    const bool is_big = h > 0.5;
+    const double x = is_big ? std::sqrt((1.0 - h) * 0.5) : h;
+    const double t = x * x;
+    double p = ASIN_SERIES.c[ASIN_TERMS - 1];
+    for (int k = ASIN_TERMS - 2; k >= 0; --k) {
+        p = p * t + ASIN_SERIES.c[k];
+    }
+    p = p * x;
+    const double half_angle = is_big ? HALF_PI - 2.0 * p : p;
+    return 2.0 * half_angle * EARTH_RADIUS;
+}
+
+void ChordsToDistancesScalar(double* values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = ChordToDistance(values[i]);
+    }
+}
+
+#ifdef TR_CAT_GEO_X86_64
+
+void ChordsToDistancesSse2(double* values, size_t count) {
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d half_pi = _mm_set1_pd(HALF_PI);
+    const __m128d radius = _mm_set1_pd(EARTH_RADIUS);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d h = _mm_min_pd(_mm_mul_pd(_mm_sqrt_pd(_mm_loadu_pd(values + i)), half), one);
+        const __m128d is_big = _mm_cmpgt_pd(h, half);
+        const __m128d reduced = _mm_sqrt_pd(_mm_mul_pd(_mm_sub_pd(one, h), half));
+        const __m128d x = _mm_or_pd(_mm_and_pd(is_big, reduced), _mm_andnot_pd(is_big, h));
+        const __m128d t = _mm_mul_pd(x, x);
+        __m128d p = _mm_set1_pd(ASIN_SERIES.c[ASIN_TERMS - 1]);
+        for (int k = ASIN_TERMS - 2; k >= 0; --k) {
+            p = _mm_add_pd(_mm_mul_pd(p, t), _mm_set1_pd(ASIN_SERIES.c[k]));
+        }
+        p = _mm_mul_pd(p, x);
+        const __m128d big_angle = _mm_sub_pd(half_pi, _mm_mul_pd(two, p));
+        const __m128d half_angle = _mm_or_pd(_mm_and_pd(is_big, big_angle), _mm_andnot_pd(is_big, p));
+        _mm_storeu_pd(values + i, _mm_mul_pd(_mm_mul_pd(two, half_angle), radius));
+    }
+    ChordsToDistancesScalar(values + i, count - i);
+}
+
+//только target("avx2") без "fma", чтобы компилятор не склеивал умножение со сложением
+__attribute__((target("avx2")))
+void ChordsToDistancesAvx2(double* values, size_t count) {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d half_pi = _mm256_set1_pd(HALF_PI);
+    const __m256d radius = _mm256_set1_pd(EARTH_RADIUS);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d h = _mm256_min_pd(_mm256_mul_pd(_mm256_sqrt_pd(_mm256_loadu_pd(values + i)), half), one);
+        const __m256d is_big = _mm256_cmp_pd(h, half, _CMP_GT_OQ);
+        const __m256d reduced = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_sub_pd(one, h), half));
+        const __m256d x = _mm256_blendv_pd(h, reduced, is_big);
+        const __m256d t = _mm256_mul_pd(x, x);
+        __m256d p = _mm256_set1_pd(ASIN_SERIES.c[ASIN_TERMS - 1]);
+        for (int k = ASIN_TERMS - 2; k >= 0; --k) {
+            p = _mm256_add_pd(_mm256_mul_pd(p, t), _mm256_set1_pd(ASIN_SERIES.c[k]));
+        }
+        p = _mm256_mul_pd(p, x);
+        const __m256d big_angle = _mm256_sub_pd(half_pi, _mm256_mul_pd(two, p));
+        const __m256d half_angle = _mm256_blendv_pd(p, big_angle, is_big);
+        _mm256_storeu_pd(values + i, _mm256_mul_pd(_mm256_mul_pd(two, half_angle), radius));
+    }
+    ChordsToDistancesScalar(values + i, count - i);
+}
+
+#endif
+
+using ChordsKernel = void (*)(double* values, size_t count);
+
+ChordsKernel SelectKernel() {
+#ifdef TR_CAT_GEO_X86_64
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ChordsToDistancesAvx2;
+    }
+    return ChordsToDistancesSse2;
+#else
+    return ChordsToDistancesScalar;
+#endif
+}
+
+} // namespace
+
+double ComputeDistance(const UnitVector& from, const UnitVector& to) {
+    return ChordToDistance(SquaredChord(from, to));
+}
+
+void ComputeDistances(const UnitVector* from, const UnitVector* to, double* distances, size_t count) {
+    static const ChordsKernel kernel = SelectKernel();
+    for (size_t begin = 0; begin < count; begin += BLOCK_SIZE) {
+        const size_t size = std::min(BLOCK_SIZE, count - begin);
+        for (size_t i = begin; i < begin + size; ++i) {
+            distances[i] = SquaredChord(from[i], to[i]);
+        }
+        kernel(distances + begin, size);
+    }
+}
+
+}//geo
+}//tr_cat
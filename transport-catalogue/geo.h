@@ -1,7 +1,8 @@
 #pragma once
 
 #include <cmath>
-inline const double EPSILON = 1e-6;
+#include <cstddef>
+#include <cstdint>
 
 namespace tr_cat {
 namespace geo {
@@ -9,25 +10,55 @@ namespace geo {
 struct Coordinates {
     double lat;
     double lng;
-    bool operator==(const Coordinates& other) const {
-        return std::abs(lat - other.lat) < EPSILON && std::abs(lng - other.lng) < EPSILON;
+};
+
+//координаты с фиксированной точкой: целое число микроградусов
+struct FixedCoordinates {
+    static constexpr double SCALE = 1e6;
+
+    int32_t lat = 0;
+    int32_t lng = 0;
+
+    static FixedCoordinates FromDegrees(Coordinates coords) {
+        return {static_cast<int32_t>(std::lround(coords.lat * SCALE)),
+                static_cast<int32_t>(std::lround(coords.lng * SCALE))};
+    }
+    Coordinates ToDegrees() const {
+        return {lat / SCALE, lng / SCALE};
+    }
+
+    bool operator==(const FixedCoordinates& other) const {
+        return lat == other.lat && lng == other.lng;
     }
-    bool operator!=(const Coordinates& other) const {
+    bool operator!=(const FixedCoordinates& other) const {
         return !(*this == other);
     }
 };
 
-inline double ComputeDistance(Coordinates from, Coordinates to) {
-    using namespace std;
-    if (from == to) {
-        return 0;
-    }
-    static const double dr = 3.1415926535 / 180.;
-    static const int earth_rad = 6371000;
+//точка на единичной сфере
+struct UnitVector {
+    double x = 0;
+    double y = 0;
+    double z = 0;
+};
 
-    return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr)) * earth_rad;
+inline const double DEG_TO_RAD = 3.1415926535 / 180.;
+inline const int EARTH_RADIUS = 6371000;
+
+inline UnitVector ToUnitVector(Coordinates coords) {
+    const double lat = coords.lat * DEG_TO_RAD;
+    const double lng = coords.lng * DEG_TO_RAD;
+    return {std::cos(lat) * std::cos(lng), std::cos(lat) * std::sin(lng), std::sin(lat)};
 }
 
+//расстояние по дуге большого круга через длину хорды: 2 * asin(|from - to| / 2) * EARTH_RADIUS
+//asin считается многочленом, относительная погрешность не больше 1e-12
+//(около 1e-5 м на 10000 км), что на порядки меньше точности вывода curvature
+double ComputeDistance(const UnitVector& from, const UnitVector& to);
+
+//пакетный вариант для массивов пар: distances[i] = ComputeDistance(from[i], to[i])
+//использует SSE2/AVX2, если их поддерживает процессор, результаты побитово совпадают со скалярным
+void ComputeDistances(const UnitVector* from, const UnitVector* to, double* distances, size_t count);
+
 }//geo
 }//tr_cat
@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 #include <graph.pb.h>
 
@@ -28,23 +29,29 @@ public:
     DirectedWeightedGraph() = default;
 
     explicit DirectedWeightedGraph(size_t vertex_count);
+    DirectedWeightedGraph(const DirectedWeightedGraph&) = delete;
+    DirectedWeightedGraph& operator=(const DirectedWeightedGraph&) = delete;
     void SetVertexCount(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    //рёбра во внешней памяти (отображённый в память файл базы), списки инцидентности при этом не строятся
+    void AttachEdges(const Edge<Weight>* edges, size_t edge_count);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    router::ranges::Range<const Edge<Weight>*> GetEdges() const {return {edges_data_, edges_data_ + edge_count_};}
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
-    transport_catalog_serialize::Graph GetSerializeData() const {
+    //рёбра [first, last), граф пишется в базу частями
+    transport_catalog_serialize::Graph GetSerializeData(EdgeId first, EdgeId last) const {
         transport_catalog_serialize::Graph graph;
-        for (const Edge<double>& edge : edges_) {
-            transport_catalog_serialize::Edge edge_out;
+        graph.mutable_edges()->Reserve(static_cast<int>(last - first));
+        for (EdgeId edge_id = first; edge_id < last; ++edge_id) {
+            const Edge<Weight>& edge = GetEdge(edge_id);
+            transport_catalog_serialize::Edge& edge_out = *graph.add_edges();
             edge_out.set_from(static_cast<uint32_t>(edge.from));
             edge_out.set_to(static_cast<uint32_t>(edge.to));
             edge_out.set_weight(edge.weight);
-            graph.add_edges();
-            *graph.mutable_edges(graph.edges_size()-1) = edge_out;
         }
         return graph;
     }
@@ -52,6 +59,9 @@ public:
 private:
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+    //рёбра, с которыми работает граф: edges_ или внешняя память
+    const Edge<Weight>* edges_data_ = nullptr;
+    size_t edge_count_ = 0;
 };
 
 template <typename Weight>
@@ -67,11 +77,20 @@ void DirectedWeightedGraph<Weight>::SetVertexCount(size_t vertex_count) {
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     edges_.push_back(edge);
+    edges_data_ = edges_.data();
+    edge_count_ = edges_.size();
     const EdgeId id = edges_.size() - 1;
     incidence_lists_.at(edge.from).push_back(id);
     return id;
 }
 
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::AttachEdges(const Edge<Weight>* edges, size_t edge_count) {
+    edges_.clear();
+    edges_data_ = edges;
+    edge_count_ = edge_count;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -79,12 +98,15 @@ size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+    return edge_count_;
 }
 
 template <typename Weight>
 const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-    return edges_.at(edge_id);
+    if (edge_id >= edge_count_) {
+        throw std::out_of_range("Graph: edge out of range");
+    }
+    return edges_data_[edge_id];
 }
 
 template <typename Weight>
@@ -1,4 +1,14 @@
 #include "json.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <thread>
 
 using namespace std;
 
@@ -6,217 +16,618 @@ namespace json {
 
 namespace {
 
-//---------------------------------------Load-------------------------------------------
+//---------------------------------------Parse-------------------------------------------
 
-Node LoadNode(istream& input);
+//первый из символов '"', '\\', '\n', '\r' в [pos, end): восемь байт проверяются за шаг.
+//Это и концы строк при разборе, и символы, которые Writer экранирует
+const char* FindStringSpecial(const char* pos, const char* end) {
+    constexpr uint64_t ONES = 0x0101010101010101;
+    constexpr uint64_t HIGHS = 0x8080808080808080;
+    auto has_byte = [](uint64_t word, unsigned char byte) {
+        const uint64_t diff = word ^ (ONES * byte);
+        return (diff - ONES) & ~diff & HIGHS;
+    };
+    for (; end - pos >= 8; pos += 8) {
+        uint64_t word;
+        memcpy(&word, pos, sizeof(word));
+        if (has_byte(word, '"') | has_byte(word, '\\') | has_byte(word, '\n') | has_byte(word, '\r')) {
+            break;
+        }
+    }
+    while (pos != end && *pos != '"' && *pos != '\\' && *pos != '\n' && *pos != '\r') {
+        ++pos;
+    }
+    return pos;
+}
 
-Node LoadNumber(std::istream& input) {
+//Структурный индекс текста: позиции символов { } [ ] , : и открывающих кавычек вне строк
+//по возрастанию. По нему границы элементов массива находятся без разбора самих элементов
+struct StructuralIndex {
+    string_view text;
+    vector<uint32_t> positions;
+};
 
-    std::string parsed_num;
+StructuralIndex BuildStructuralIndex(string_view text) {
+    StructuralIndex index{text, {}};
+    const char* const begin = text.data();
+    const char* const end = begin + text.size();
+    for (const char* pos = begin; pos != end; ++pos) {
+        switch (*pos) {
+        case '"':
+            index.positions.push_back(static_cast<uint32_t>(pos - begin));
+            //конец строки; незакрытую строку или перевод строки в ней найдёт разбор
+            for (++pos; (pos = FindStringSpecial(pos, end)) != end && *pos != '"'; ++pos) {
+                if (*pos == '\\' && pos + 1 != end) {
+                    ++pos;
+                }
+            }
+            if (pos == end) {
+                return index;
+            }
+            break;
+        case '{': case '}': case '[': case ']': case ',': case ':':
+            index.positions.push_back(static_cast<uint32_t>(pos - begin));
+            break;
+        default:
+            break;
+        }
+    }
+    return index;
+}
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
+//события разбора части массива: части разбираются параллельно, а обработчику
+//события передаются в исходном порядке. Строки, лежащие в тексте, не копируются
+class Tape final : public Handler {
+public:
+    explicit Tape(string_view text)
+        : text_(text) {}
+
+    void StartDict() override {events_.push_back({Kind::START_DICT, {}, {}});}
+    void EndDict() override {events_.push_back({Kind::END_DICT, {}, {}});}
+    void StartArray() override {events_.push_back({Kind::START_ARRAY, {}, {}});}
+    void EndArray() override {events_.push_back({Kind::END_ARRAY, {}, {}});}
+    void Key(string_view key) override {events_.push_back({Kind::KEY, Keep(key), {}});}
+    void String(string_view value) override {events_.push_back({Kind::STRING, Keep(value), {}});}
+    void Value(Node value) override {events_.push_back({Kind::VALUE, {}, move(value)});}
+
+    //ошибка разбора части: передаётся после событий, которые ей предшествовали
+    exception_ptr error;
+
+    void Replay(Handler& handler) {
+        for (Event& event : events_) {
+            switch (event.kind) {
+            case Kind::START_DICT: handler.StartDict(); break;
+            case Kind::END_DICT: handler.EndDict(); break;
+            case Kind::START_ARRAY: handler.StartArray(); break;
+            case Kind::END_ARRAY: handler.EndArray(); break;
+            case Kind::KEY: handler.Key(event.text); break;
+            case Kind::STRING: handler.String(event.text); break;
+            case Kind::VALUE: handler.Value(move(event.value)); break;
+            }
         }
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+    void Clear() {
+        events_.clear();
+        copies_.clear();
+        error = nullptr;
+    }
+
+private:
+    enum class Kind : uint8_t {START_DICT, END_DICT, START_ARRAY, END_ARRAY, KEY, STRING, VALUE};
+    struct Event {
+        Kind kind;
+        string_view text;
+        Node value;
     };
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!isdigit(input.peek())) {
+    string_view text_;
+    vector<Event> events_;
+    deque<string> copies_; //строки с escape-последовательностями
+
+    string_view Keep(string_view value) {
+        if (value.data() >= text_.data() && value.data() + value.size() <= text_.data() + text_.size()) {
+            return value;
+        }
+        return copies_.emplace_back(value);
+    }
+};
+
+//Разбор идёт по буферу: строки без escape-последовательностей передаются обработчику
+//прямо из него, числа переводятся через from_chars без промежуточной строки.
+//Поток читается блоками по BLOCK_SIZE; непрочитанный хвост буфера при дочитывании переносится
+//в начало, поэтому любая лексема лежит в буфере целиком, а буфер растёт только под длинную лексему.
+//Если ввод сохраняется (keep_), каждый блок выделяется заново и хвост копируется в новый блок,
+//а строки с escape-последовательностями раскрываются тоже в keep_
+class Parser {
+public:
+    Parser(string_view text, Handler& handler)
+        : pos_(text.data()), end_(text.data() + text.size()), handler_(handler) {}
+
+    Parser(istream& input, Handler& handler)
+        : input_(&input), buffer_(BLOCK_SIZE), handler_(handler) {
+        pos_ = end_ = buffer_.data();
+    }
+
+    Parser(istream& input, Handler& handler, pmr::memory_resource* keep)
+        : input_(&input), keep_(keep), handler_(handler) {}
+
+    //текст в памяти со структурным индексом: большие массивы верхних уровней
+    //разбираются по частям параллельно
+    Parser(const StructuralIndex& index, Handler& handler)
+        : Parser(index.text, handler) {
+        index_ = &index;
+    }
+
+    //пустой ввод - ни одного события
+    void Parse() {
+        if (SkipSpaces()) {
+            ParseNode();
+        }
+    }
+
+    //ровно одно значение, вокруг которого только пробельные символы
+    void ParseElement() {
+        if (!SkipSpaces()) {
+            //как при разборе подряд: на месте элемента ',' или ']', а не число
             throw ParsingError("A digit is expected"s);
         }
-        while (isdigit(input.peek())) {
-            read_char();
+        ParseNode();
+        if (SkipSpaces()) {
+            //как при разборе подряд: за значением элемента нет ','
+            throw ParsingError("',' expected"s);
         }
-    };
+    }
 
-    if (input.peek() == '-') {
-        read_char();
+private:
+    static constexpr size_t BLOCK_SIZE = 1 << 16;
+    //делятся массивы в корне документа и прямо в корневом контейнере
+    static constexpr int MAX_SPLIT_DEPTH = 1;
+    //меньшие массивы разбираются подряд
+    static constexpr size_t MIN_SPLIT_PART = 256;
+    //элементов на поток за раз: события копятся только для них
+    static constexpr size_t WINDOW_PART = 1024;
+
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    istream* input_ = nullptr;
+    vector<char> buffer_;
+    pmr::memory_resource* keep_ = nullptr;
+    string unescaped_;
+    Handler& handler_;
+    const StructuralIndex* index_ = nullptr;
+    int depth_ = 0; //число незакрытых контейнеров
+
+    //дочитывает поток, сохраняя буфер начиная с keep; keep и pos_ сдвигаются вместе с ним.
+    //false, если дочитать нечего
+    bool Refill(const char*& keep) {
+        if (!input_ || !*input_) {
+            return false;
+        }
+        const size_t pos_offset = static_cast<size_t>(pos_ - keep);
+        const size_t tail = static_cast<size_t>(end_ - keep);
+        char* block;
+        size_t block_size;
+        if (keep_) {
+            block_size = max(BLOCK_SIZE, tail * 2);
+            block = static_cast<char*>(keep_->allocate(block_size, 1));
+            if (tail != 0) {
+                memcpy(block, keep, tail);
+            }
+        } else {
+            memmove(buffer_.data(), keep, tail);
+            if (tail == buffer_.size()) {
+                buffer_.resize(buffer_.size() * 2);
+            }
+            block = buffer_.data();
+            block_size = buffer_.size();
+        }
+        input_->read(block + tail, static_cast<streamsize>(block_size - tail));
+        const size_t read = static_cast<size_t>(input_->gcount());
+        keep = block;
+        pos_ = keep + pos_offset;
+        end_ = keep + tail + read;
+        return read > 0;
     }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
+
+    //есть ли ещё символ в позиции pos_, при необходимости дочитывает поток
+    bool HasChar(const char*& keep) {
+        return pos_ != end_ || Refill(keep);
     }
 
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
+    //пропускает пробельные символы, false - если ввод закончился
+    bool SkipSpaces() {
+        while (true) {
+            while (pos_ != end_ && isspace(static_cast<unsigned char>(*pos_))) {
+                ++pos_;
+            }
+            const char* keep = pos_;
+            if (pos_ != end_ || !Refill(keep)) {
+                return pos_ != end_;
+            }
+        }
     }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    char NextChar(const char* error) {
+        if (!SkipSpaces()) {
+            throw ParsingError(error);
         }
-        read_digits();
-        is_int = false;
+        return *pos_++;
     }
 
-    try {
-        if (is_int) {
-            return Node(stoi(parsed_num));
+    void ParseNode() {
+        switch (*pos_) {
+        case '[':
+            ++pos_;
+            ParseArray();
+            break;
+        case '{':
+            ++pos_;
+            ParseDict();
+            break;
+        case '"':
+            ++pos_;
+            handler_.String(ParseString());
+            break;
+        case 'n':
+            ParseLiteral("null"sv);
+            handler_.Value(Node());
+            break;
+        case 't':
+            ParseLiteral("true"sv);
+            handler_.Value(Node(true));
+            break;
+        case 'f':
+            ParseLiteral("false"sv);
+            handler_.Value(Node(false));
+            break;
+        default:
+            handler_.Value(ParseNumber());
         }
-        return Node(stod(parsed_num));
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
     }
-}
 
-Node LoadString(std::istream& input) {
-    using namespace std::literals;
-    
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            // Поток закончился до того, как встретили закрывающую кавычку?
-            throw ParsingError("String parsing error");
+    void ParseLiteral(string_view literal) {
+        const char* keep = pos_;
+        while (static_cast<size_t>(end_ - pos_) < literal.size() && Refill(keep)) {
         }
-        const char ch = *it;
-        if (ch == '"') {
-            // Встретили закрывающую кавычку
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            // Встретили начало escape-последовательности
-            ++it;
-            if (it == end) {
-                // Поток завершился сразу после символа обратной косой черты
+        if (static_cast<size_t>(end_ - pos_) < literal.size() || string_view(pos_, literal.size()) != literal) {
+            throw ParsingError("Unexpected value"s);
+        }
+        pos_ += literal.size();
+    }
+
+    Node ParseNumber() {
+        const char* begin = pos_;
+        auto is_next = [this, &begin](auto predicate) {
+            return HasChar(begin) && predicate(*pos_);
+        };
+        auto is_digit = [](char c) {return isdigit(static_cast<unsigned char>(c)) != 0;};
+        auto read_digits = [this, &is_next, is_digit] {
+            if (!is_next(is_digit)) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (is_next(is_digit)) {
+                ++pos_;
+            }
+        };
+
+        if (is_next([](char c) {return c == '-';})) {
+            ++pos_;
+        }
+        // После 0 в JSON не могут идти другие цифры
+        if (is_next([](char c) {return c == '0';})) {
+            ++pos_;
+        } else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        if (is_next([](char c) {return c == '.';})) {
+            ++pos_;
+            read_digits();
+            is_int = false;
+        }
+        if (is_next([](char c) {return c == 'e' || c == 'E';})) {
+            ++pos_;
+            if (is_next([](char c) {return c == '+' || c == '-';})) {
+                ++pos_;
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        if (is_int) {
+            int value;
+            if (auto [ptr, error] = from_chars(begin, pos_, value); error == errc() && ptr == pos_) {
+                return Node(value);
+            }
+        } else {
+            double value;
+            if (auto [ptr, error] = from_chars(begin, pos_, value); error == errc() && ptr == pos_) {
+                return Node(value);
+            }
+        }
+        throw ParsingError("Failed to convert "s + string(begin, pos_) + " to number"s);
+    }
+
+
+    //открывающая кавычка уже прочитана; результат действителен до следующего чтения,
+    //если ввод не сохраняется
+    string_view ParseString() {
+        const char* begin = pos_;
+        bool has_escapes = false;
+        while (true) {
+            pos_ = FindStringSpecial(pos_, end_);
+            if (pos_ == end_) {
+                if (!Refill(begin)) {
+                    // Ввод закончился до того, как встретили закрывающую кавычку
+                    throw ParsingError("String parsing error");
+                }
+                continue;
+            }
+            if (*pos_ == '"') {
+                break;
+            }
+            if (*pos_ == '\n' || *pos_ == '\r') {
+                // Строковый литерал внутри JSON не может прерываться символами \r или \n
+                throw ParsingError("Unexpected end of line"s);
+            }
+            has_escapes = true;
+            ++pos_;
+            if (!HasChar(begin)) {
+                // Ввод завершился сразу после символа обратной косой черты
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
+            ++pos_;
+        }
+        const string_view raw(begin, static_cast<size_t>(pos_ - begin));
+        ++pos_;
+        return has_escapes ? Unescape(raw) : raw;
+    }
+
+    string_view Unescape(string_view raw) {
+        unescaped_.clear();
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] != '\\') {
+                unescaped_.push_back(raw[i]);
+                continue;
+            }
             // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
+            const char escaped_char = raw[++i];
             switch (escaped_char) {
                 case 'n':
-                    s.push_back('\n');
+                    unescaped_.push_back('\n');
                     break;
                 case 't':
-                    s.push_back('\t');
+                    unescaped_.push_back('\t');
                     break;
                 case 'r':
-                    s.push_back('\r');
+                    unescaped_.push_back('\r');
                     break;
                 case '"':
-                    s.push_back('"');
+                    unescaped_.push_back('"');
                     break;
                 case '\\':
-                    s.push_back('\\');
+                    unescaped_.push_back('\\');
                     break;
                 default:
-                    // Встретили неизвестную escape-последовательность
                     throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            // Строковый литерал внутри- JSON не может прерываться символами \r или \n
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            // Просто считываем очередной символ и помещаем его в результирующую строку
-            s.push_back(ch);
         }
-        ++it;
+        if (!keep_) {
+            return unescaped_;
+        }
+        char* data = static_cast<char*>(keep_->allocate(unescaped_.size(), 1));
+        memcpy(data, unescaped_.data(), unescaped_.size());
+        return {data, unescaped_.size()};
     }
 
-    return Node(move(s));
-}
+    void ParseArray() {
+        handler_.StartArray();
+        if (index_ && depth_ <= MAX_SPLIT_DEPTH && ParseSplit()) {
+            handler_.EndArray();
+            return;
+        }
+        ++depth_;
+        if (NextChar("] not expected") != ']') {
+            --pos_;
+            while (true) {
+                ParseNode();
+                const char c = NextChar("] not expected");
+                if (c == ']') {
+                    break;
+                }
+                if (c != ',') {
+                    throw ParsingError("',' expected"s);
+                }
+                if (!SkipSpaces()) {
+                    throw ParsingError("] not expected"s);
+                }
+            }
+        }
+        --depth_;
+        handler_.EndArray();
+    }
+
+    //pos_ - сразу за '['. Границы элементов берутся из индекса, части разбираются в Tape
+    //параллельно и передаются обработчику по порядку; false - массив нужно разобрать подряд
+    bool ParseSplit() {
+        const char* const text = index_->text.data();
+        const vector<uint32_t>& positions = index_->positions;
+        auto it = lower_bound(positions.begin(), positions.end(), static_cast<uint32_t>(pos_ - 1 - text));
+        if (it == positions.end() || text + *it != pos_ - 1) {
+            return false;
+        }
+        //позиции ',' между элементами и закрывающей ']'
+        vector<const char*> ends;
+        int depth = 0;
+        for (++it; it != positions.end(); ++it) {
+            const char c = text[*it];
+            if (c == '[' || c == '{') {
+                ++depth;
+            } else if (c == ']' || c == '}') {
+                if (depth-- == 0) {
+                    break;
+                }
+            } else if (c == ',' && depth == 0) {
+                ends.push_back(text + *it);
+            }
+        }
+        if (it == positions.end() || text[*it] != ']') {
+            return false;
+        }
+        ends.push_back(text + *it);
+        const size_t count = ends.size();
+        const size_t parts = tr_cat::parallel::GetPartsCount(count, MIN_SPLIT_PART);
+        if (parts == 1) {
+            return false;
+        }
+
+        vector<Tape> tapes(parts, Tape(index_->text));
+        for (size_t window = 0; window < count; window += parts * WINDOW_PART) {
+            const size_t window_end = min(count, window + parts * WINDOW_PART);
+            tr_cat::parallel::ForEachRange(parts, 1, [&](size_t first_part, size_t last_part) {
+                for (size_t part = first_part; part < last_part; ++part) {
+                    const size_t first = window + part * (window_end - window) / parts;
+                    const size_t last = window + (part + 1) * (window_end - window) / parts;
+                    try {
+                        for (size_t element = first; element < last; ++element) {
+                            const char* begin = element == 0 ? pos_ : ends[element - 1] + 1;
+                            Parser(string_view(begin, static_cast<size_t>(ends[element] - begin)), tapes[part])
+                                .ParseElement();
+                        }
+                    } catch (...) {
+                        tapes[part].error = current_exception();
+                    }
+                }
+            });
+            for (Tape& tape : tapes) {
+                tape.Replay(handler_);
+                tape.Clear();
+            }
+        }
+        pos_ = ends.back() + 1;
+        return true;
+    }
 
-Node LoadNull(istream& input) {
-    string s;
-    char c;
-    for (int i = 0; input >> c && i < 4; ++i) {
-        s += c;
-    }  
-    if (s != "null"s) {
-        throw ParsingError("Unexpected value"s);
+    void ParseDict() {
+        handler_.StartDict();
+        ++depth_;
+        char c = NextChar("} not expected");
+        while (c != '}') {
+            if (c != '"') {
+                throw ParsingError("Dict key expected"s);
+            }
+            handler_.Key(ParseString());
+            if (NextChar("} not expected") != ':' || !SkipSpaces()) {
+                throw ParsingError("':' expected"s);
+            }
+            ParseNode();
+            c = NextChar("} not expected");
+            if (c == ',') {
+                c = NextChar("} not expected");
+            } else if (c != '}') {
+                throw ParsingError("',' expected"s);
+            }
+        }
+        --depth_;
+        handler_.EndDict();
     }
-    return Node();
+};
+
+}  // namespace
+
+//------------------------------------Dict-------------------------------------
+
+namespace {
+
+const ptrdiff_t SMALL_DICT_SIZE = 32;
+
+bool KeyLess(const Dict::value_type& item, string_view key) {
+    return item.first < key;
 }
 
-Node LoadBool(istream& input) {
-    string s;
-    char c;
+}  // namespace
 
-    for (; input >> c && s.size() < 5 && c != 'e';s += c);
-    s += c;
+Dict::Dict(pmr::memory_resource* resource)
+    : items_(resource) {
+}
 
-    if (s == "true"s) {
-        return Node(true);
-    }
-    if (s == "false"s) {
-        return Node(false);
-    }
-    throw ParsingError("Unexpected value"s);
+Dict::iterator Dict::begin() {
+    return items_.begin();
 }
 
-Node LoadArray(istream& input) {
-    Array result;
-    char c;
-    for (; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
-        }
-        result.push_back(move(LoadNode(input)));
-    }
+Dict::iterator Dict::end() {
+    return items_.end();
+}
 
-    if (c != ']') {
-        throw ParsingError("] not expected"s);
-    }
+Dict::const_iterator Dict::begin() const {
+    return items_.begin();
+}
 
-    return Node(move(result));
+Dict::const_iterator Dict::end() const {
+    return items_.end();
 }
 
-Node LoadDict(istream& input) {
-    Dict result;
-    char c;
-    for (; input >> c && c != '}';) {
-        if (c == ',') {
-            input >> c;
-        }
+size_t Dict::size() const {
+    return items_.size();
+}
 
-        string key = LoadString(input).AsString();
-        input >> c;
-        result.insert({move(key), LoadNode(input)});
-    }
+bool Dict::empty() const {
+    return items_.empty();
+}
+
+void Dict::reserve(size_t size) {
+    items_.reserve(size);
+}
+
+Dict::iterator Dict::find(string_view key) {
+    auto it = lower_bound(items_.begin(), items_.end(), key, KeyLess);
+    return it != items_.end() && it->first == key ? it : items_.end();
+}
+
+Dict::const_iterator Dict::find(string_view key) const {
+    auto it = lower_bound(items_.begin(), items_.end(), key, KeyLess);
+    return it != items_.end() && it->first == key ? it : items_.end();
+}
+
+size_t Dict::count(string_view key) const {
+    return find(key) != items_.end() ? 1 : 0;
+}
 
-    if (c != '}') {
-        throw ParsingError("} not expected"s);
+Node& Dict::at(string_view key) {
+    auto it = find(key);
+    if (it == items_.end()) {
+        throw out_of_range("Key not found: "s + string(key));
     }
+    return it->second;
+}
 
-    return Node(move(result));
+const Node& Dict::at(string_view key) const {
+    auto it = find(key);
+    if (it == items_.end()) {
+        throw out_of_range("Key not found: "s + string(key));
+    }
+    return it->second;
 }
 
-Node LoadNode(istream& input) {
-    char c;
-    if(input >> c) {
-        if (c == '[') {
-            return move(LoadArray(input));
-        } else if (c == '{') {
-            return move(LoadDict(input));
-        } else if (c == '"') {
-            return move(LoadString(input));
-        } else if (c == 'n') {
-            input.putback(c);
-            return LoadNull(input);
-        } else if (c == 't' || c == 'f') {
-            input.putback(c);
-            return LoadBool(input);
-        } else {
-            input.putback(c);
-            return LoadNumber(input);
-        }
-    } else return {};
+pair<Dict::iterator, bool> Dict::emplace(string_view key, Node value) {
+    //ключи обычно приходят уже упорядоченными, тогда вставка - добавление в конец
+    auto it = items_.empty() || items_.back().first < key
+              ? items_.end()
+              : lower_bound(items_.begin(), items_.end(), key, KeyLess);
+    if (it != items_.end() && it->first == key) {
+        return {it, false};
+    }
+    return {items_.emplace(it, key, move(value)), true};
 }
 
-}  // namespace
+bool Dict::operator== (const Dict& other) const {
+    return items_ == other.items_;
+}
 
 //------------------------------------Node-------------------------------------
 
@@ -229,15 +640,42 @@ Node::Node(const int value)
 Node::Node(const double value)
     : data_(value) {}
 
-Node::Node(const string value)
+Node::Node(string value)
     : data_(move(value)) {}
 
-Node::Node(const Array value)
-    : data_(move(value)) {}
+Node::Node(const char* value)
+    : data_(string(value)) {}
 
-Node::Node(const Dict map)
+Node::Node(string_view value)
+    : data_(value) {}
+
+Node::Node(Array array)
+    : data_(move(array)) {}
+
+Node::Node(Dict map)
     : data_(move(map)) {}
 
+Node::Node(const Node& other)
+    : data_(other.data_) {
+    if (const string_view* value = get_if<string_view>(&data_)) {
+        data_ = string(*value);
+    }
+}
+
+Node& Node::operator= (const Node& other) {
+    if (this != &other) {
+        *this = Node(other);
+    }
+    return *this;
+}
+
+bool Node::operator== (const Node& other) const {
+    if (IsString() && other.IsString()) {
+        return AsString() == other.AsString();
+    }
+    return data_ == other.data_;
+}
+
 //--------------------------------------As-------------------------------------------
 
 bool Node::AsBool() {
@@ -264,7 +702,10 @@ double Node::AsDouble() {
     throw logic_error("Is not Double"s);
 }
 
-string& Node::AsString() {
+string_view Node::AsString() const {
+    if (const string_view* value = get_if<string_view>(&data_)) {
+        return *value;
+    }
     if (!IsString()) {
         throw logic_error("Is not String"s);
     }
@@ -291,23 +732,42 @@ Document::Document(Node root)
     : root_(move(root)) {
 }
 
+Document::Document(Node root, unique_ptr<pmr::monotonic_buffer_resource> arena)
+    : arena_(move(arena))
+    , root_(move(root)) {
+}
+
+//прежнее дерево удаляется раньше своей арены; копии узлов выделяются из кучи,
+//перемещённое дерево продолжает ссылаться на арену other
 Document& Document::operator= (Document& other) {
-    root_ = other.root_;
+    if (this != &other) {
+        root_ = Node{};
+        arena_.reset();
+        root_ = other.root_;
+    }
     return *this;
 }
 
+//узел может быть частью этого же документа и ссылаться на его арену, поэтому арена остаётся
+//до конца жизни документа или до присваивания ему другого документа
 Document& Document::operator= (Node& other) {
-    root_ = other;
+    Node copy = other;
+    root_ = move(copy);
     return *this;
 }
 
 Document& Document::operator= (Document&& other) {
-    root_ = move(other.root_);
+    if (this != &other) {
+        root_ = Node{};
+        arena_ = move(other.arena_);
+        root_ = move(other.root_);
+    }
     return *this;
 }
 
 Document& Document::operator= (Node&& other) {
-    root_ = move(other);
+    Node value = move(other);
+    root_ = move(value);
     return *this;
 }
 
@@ -315,129 +775,401 @@ Node& Document::GetRoot() {
     return root_;
 }
 
-Document Load(istream& input) {
-    return Document{LoadNode(input)};
+//--------------------------------------NodeBuilder-------------------------------------
+
+NodeBuilder::NodeBuilder(bool reference_strings)
+    : arena_(make_unique<pmr::monotonic_buffer_resource>())
+    , reference_strings_(reference_strings) {
 }
 
-//----------------------------------------------Print-------------------------------------------
+void NodeBuilder::StartDict() {
+    stack_.push_back({true, items_.size(), {}});
+}
 
-struct PrintContext {
-    std::ostream& out;
-    int indent_step = 4;
-    int indent = 0;
+void NodeBuilder::EndDict() {
+    Frame frame = move(stack_.back());
+    stack_.pop_back();
+    //небольшие словари упорядочиваются вставкой, большие - заранее стабильной сортировкой,
+    //которая сохраняет первое из значений с одинаковым ключом
+    auto first = items_.begin() + frame.first;
+    if (items_.end() - first > SMALL_DICT_SIZE) {
+        stable_sort(first, items_.end(), [](const Item& lhs, const Item& rhs) {
+            return lhs.first < rhs.first;
+        });
+    }
+    Dict dict(arena_.get());
+    dict.reserve(items_.end() - first);
+    for (auto it = first; it != items_.end(); ++it) {
+        dict.emplace(it->first, move(it->second));
+    }
+    items_.erase(first, items_.end());
+    Add(Node(move(dict)));
+}
 
-    void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
-        }
+void NodeBuilder::StartArray() {
+    stack_.push_back({false, values_.size(), {}});
+}
+
+void NodeBuilder::EndArray() {
+    const size_t first = stack_.back().first;
+    stack_.pop_back();
+    Array array(arena_.get());
+    array.reserve(values_.size() - first);
+    array.insert(array.end(), make_move_iterator(values_.begin() + first), make_move_iterator(values_.end()));
+    values_.erase(values_.begin() + first, values_.end());
+    Add(Node(move(array)));
+}
+
+void NodeBuilder::Key(string_view key) {
+    stack_.back().key = key;
+}
+
+void NodeBuilder::String(string_view value) {
+    if (!reference_strings_) {
+        char* data = static_cast<char*>(arena_->allocate(value.size(), 1));
+        memcpy(data, value.data(), value.size());
+        value = {data, value.size()};
     }
+    Add(Node(value));
+}
+
+void NodeBuilder::Value(Node value) {
+    Add(move(value));
+}
+
+Document NodeBuilder::Build() {
+    return Document{move(root_), move(arena_)};
+}
 
-    PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+void NodeBuilder::Add(Node value) {
+    if (stack_.empty()) {
+        root_ = move(value);
+        return;
     }
-};
+    Frame& frame = stack_.back();
+    if (frame.is_dict) {
+        items_.emplace_back(move(frame.key), move(value));
+    } else {
+        values_.push_back(move(value));
+    }
+}
 
-void PrintNode(const Node& node, const PrintContext& ctx, bool enter = true);
+//----------------------------------------Load-----------------------------------------
 
-void PrintValue(nullptr_t, const PrintContext& ctx, bool) {
-    ctx.out << "null"sv;
+void Parse(istream& input, Handler& handler) {
+    Parser(input, handler).Parse();
 }
 
-void PrintValue(const string& value, const  PrintContext& ctx, bool) {
-    ctx.out << '"';
-    for (char c : value) {
-        switch (c) {
-        case '"':
-            ctx.out << "\\\""sv;
-            break;
-        case '\n':
-            ctx.out << "\\n"sv;
-            break;
-        case '\t':
-            ctx.out << "\t"sv;
+void Parse(istream& input, Handler& handler, pmr::memory_resource* keep_input) {
+    Parser(input, handler, keep_input).Parse();
+}
+
+void Parse(string_view text, Handler& handler) {
+    Parser(text, handler).Parse();
+}
+
+void ParseParallel(string_view text, Handler& handler) {
+    if (thread::hardware_concurrency() <= 1 || text.size() > numeric_limits<uint32_t>::max()) {
+        Parser(text, handler).Parse();
+        return;
+    }
+    const StructuralIndex index = BuildStructuralIndex(text);
+    Parser(index, handler).Parse();
+}
+
+void ParseParallel(istream& input, Handler& handler) {
+    if (thread::hardware_concurrency() <= 1) {
+        Parser(input, handler).Parse();
+        return;
+    }
+    constexpr size_t BLOCK_SIZE = 1 << 16;
+    string text;
+    while (input) {
+        const size_t size = text.size();
+        text.resize(size + BLOCK_SIZE);
+        input.read(text.data() + size, BLOCK_SIZE);
+        text.resize(size + static_cast<size_t>(input.gcount()));
+    }
+    ParseParallel(text, handler);
+}
+
+Document Load(string_view text) {
+    NodeBuilder builder;
+    ParseParallel(text, builder);
+    return builder.Build();
+}
+
+Document Load(istream& input) {
+    NodeBuilder builder(true);
+    Parse(input, builder, builder.GetArena());
+    return builder.Build();
+}
+
+//----------------------------------------------Writer------------------------------------------
+
+Writer::Writer(ostream& output, int indent_step, int indent, int precision)
+    : output_(output)
+    , indent_step_(indent_step)
+    , indent_(indent)
+    , precision_(precision) {
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::StartDict() {
+    StartValue();
+    Put('{');
+    Open();
+}
+
+void Writer::EndDict() {
+    Close();
+    Put('}');
+}
+
+void Writer::StartArray() {
+    StartValue();
+    Put('[');
+    Open();
+}
+
+void Writer::EndArray() {
+    Close();
+    Put(']');
+}
+
+//ключ печатается как есть, без экранирования
+void Writer::Key(string_view key) {
+    NextItem();
+    Put('"');
+    Write(key);
+    Write(indent_step_ ? "\": "sv : "\":"sv);
+    after_key_ = true;
+}
+
+void Writer::String(string_view value) {
+    StartString();
+    StringPart(value);
+    EndString();
+}
+
+void Writer::StartString() {
+    StartValue();
+    Put('"');
+}
+
+void Writer::StringPart(string_view value) {
+    while (!value.empty()) {
+        const char* special = FindStringSpecial(value.data(), value.data() + value.size());
+        const size_t run = static_cast<size_t>(special - value.data());
+        Write(value.substr(0, run));
+        if (run == value.size()) {
             break;
-        case '\r':
-            ctx.out << "\\r"sv;
+        }
+        switch (*special) {
+        case '"':
+            Write("\\\""sv);
             break;
         case '\\':
-            ctx.out << "\\\\"sv;
+            Write("\\\\"sv);
+            break;
+        case '\n':
+            Write("\\n"sv);
             break;
         default:
-            ctx.out << c;
+            Write("\\r"sv);
             break;
         }
+        value.remove_prefix(run + 1);
     }
-    ctx.out << '"';
 }
 
-template <typename Number>
-void PrintValue (const Number value, const PrintContext& ctx, bool) {
-    ctx.out << boolalpha;
-    ctx.out << value;
+void Writer::EndString() {
+    Put('"');
 }
 
-void PrintValue (const Array& value, const PrintContext& ctx, bool enter = true) {
+void Writer::Value(Node value) {
+    WriteNode(value);
+}
 
-    auto print_elems = [&value](const PrintContext& ctx) {
-        bool is_first = false;
-        for (const auto& elem : value) {
-            if (is_first) {
-                ctx.out << ",\n"sv;
+void Writer::WriteNode(const Node& node) {
+    visit([this](const auto& value) {
+        using Type = decay_t<decltype(value)>;
+        if constexpr (is_same_v<Type, Array>) {
+            StartArray();
+            for (const Node& item : value) {
+                WriteNode(item);
             }
-            is_first = true;
-            ctx.PrintIndent();
-            PrintNode(elem, ctx, false);
+            EndArray();
+        } else if constexpr (is_same_v<Type, Dict>) {
+            StartDict();
+            for (const auto& [key, item] : value) {
+                Key(key);
+                WriteNode(item);
+            }
+            EndDict();
+        } else if constexpr (is_same_v<Type, std::string> || is_same_v<Type, string_view>) {
+            String(value);
+        } else {
+            StartValue();
+            WriteScalar(value);
         }
-    };
+    }, node.GetValue());
+}
+
+void Writer::WriteScalar(nullptr_t) {
+    Write("null"sv);
+}
+
+void Writer::WriteScalar(bool value) {
+    Write(value ? "true"sv : "false"sv);
+}
+
+void Writer::WriteScalar(int value) {
+    char text[16];
+    const auto result = to_chars(begin(text), end(text), value);
+    Write({text, static_cast<size_t>(result.ptr - text)});
+}
+
+void Writer::WriteScalar(double value) {
+    char text[numbers::MAX_SIZE];
+    const char* end = numbers::Format(text, value, precision_);
+    Write({text, static_cast<size_t>(end - text)});
+}
 
-    if (enter) {
-        ctx.PrintIndent();
+void Writer::RawValue(string_view text) {
+    StartValue();
+    Write(text);
+}
+
+StringStream::StringStream(Writer& writer)
+    : std::ostream(static_cast<std::streambuf*>(this))
+    , writer_(writer) {
+    setp(buffer_, buffer_ + BUFFER_SIZE);
+    writer_.StartString();
+}
+
+StringStream::~StringStream() {
+    sync();
+    writer_.EndString();
+}
+
+int StringStream::overflow(int c) {
+    sync();
+    if (c != std::streambuf::traits_type::eof()) {
+        *pptr() = std::streambuf::traits_type::to_char_type(c);
+        pbump(1);
     }
-    ctx.out << "[\n"sv;
-    
-    print_elems(ctx.Indented());
+    return std::streambuf::traits_type::not_eof(c);
+}
 
-    ctx.out << '\n';
-    ctx.PrintIndent();
-    ctx.out << "]"sv;
+streamsize StringStream::xsputn(const char* text, streamsize size) {
+    if (size < static_cast<streamsize>(BUFFER_SIZE)) {
+        return std::streambuf::xsputn(text, size);
+    }
+    //длинный кусок, например SVG из базы, экранируется без копирования в буфер
+    sync();
+    writer_.StringPart(string_view(text, static_cast<size_t>(size)));
+    return size;
 }
 
-void PrintValue (const Dict& value, const PrintContext& ctx, bool enter = true) {
-    
-    auto print_elems = [&value](const PrintContext& ctx) {
-        bool is_first = false;
-        for (const auto& elem : value) {
-            if (is_first) {
-                ctx.out << ",\n"sv;
-            }
-            is_first = true;
-            ctx.PrintIndent();
-            ctx.out << "\""sv << elem.first << "\": "sv;
-            PrintNode(elem.second, ctx, false);
+int StringStream::sync() {
+    writer_.StringPart(string_view(pbase(), static_cast<size_t>(pptr() - pbase())));
+    setp(buffer_, buffer_ + BUFFER_SIZE);
+    return 0;
+}
+
+void Writer::Flush() {
+    output_.write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::Reset() {
+    buffer_.clear();
+    indent_ -= indent_step_ * static_cast<int>(is_first_.size());
+    is_first_.clear();
+    after_key_ = false;
+}
+
+void Writer::Write(string_view text) {
+    if (buffer_.size() + text.size() > BUFFER_SIZE) {
+        Flush();
+        //длинный текст, например SVG карты, пишется в поток напрямую
+        if (text.size() >= BUFFER_SIZE) {
+            output_.write(text.data(), static_cast<streamsize>(text.size()));
+            return;
         }
-    };
-    if (enter) {
-        ctx.PrintIndent();
     }
+    buffer_.append(text);
+}
 
-    ctx.out << "{\n"sv;
-    
-    print_elems(ctx.Indented());
+void Writer::Put(char c) {
+    if (buffer_.size() == BUFFER_SIZE) {
+        Flush();
+    }
+    buffer_.push_back(c);
+}
 
-    ctx.out << '\n';
-    ctx.PrintIndent();
-    ctx.out << "}"sv;
+void Writer::WriteIndent() {
+    if (indent_step_ == 0) {
+        return;
+    }
+    Put('\n');
+    if (spaces_.size() < static_cast<size_t>(indent_)) {
+        spaces_.assign(static_cast<size_t>(indent_) * 2, ' ');
+    }
+    Write(string_view(spaces_).substr(0, static_cast<size_t>(indent_)));
 }
 
-void PrintNode(const Node& node, const PrintContext& ctx, bool enter) {
-    visit([&ctx, enter](const auto& value) {PrintValue(value, ctx, enter);}, node.GetValue());
+void Writer::NextItem() {
+    if (!is_first_.empty() && !is_first_.back()) {
+        Put(',');
+    }
+    if (!is_first_.empty()) {
+        is_first_.back() = false;
+        WriteIndent();
+    }
+}
+
+void Writer::StartValue() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    NextItem();
+}
 
+void Writer::Open() {
+    is_first_.push_back(true);
+    indent_ += indent_step_;
 }
 
+void Writer::Close() {
+    indent_ -= indent_step_;
+    //пустой контейнер печатается с пустой строкой внутри, как его всегда печатал json::Print
+    if (is_first_.back() && indent_step_ != 0) {
+        Put('\n');
+    }
+    is_first_.pop_back();
+    WriteIndent();
+}
+
+//----------------------------------------------Print-------------------------------------------
+
 void Print(Document& doc, std::ostream& out) {
-    PrintContext ctx({out, TAB, 0});
-    PrintNode(doc.GetRoot(), ctx);
+    {
+        Writer writer(out);
+        writer.WriteNode(doc.GetRoot());
+    }
     out << endl;
 }
 
+void Print(const Node& node, std::ostream& out, int indent) {
+    Writer writer(out, TAB, indent);
+    writer.WriteNode(node);
+}
+
 }  // namespace json
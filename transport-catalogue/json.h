@@ -2,19 +2,63 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 #include <optional>
 #include <utility>
-#include <map>
 #include <iomanip>
+#include <memory>
+#include <memory_resource>
+
+#include "numbers.h"
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
-using NodeType = std::variant<std::nullptr_t, bool, int, double, std::string, Array, Dict>;
+
+//массивы и словари документа, прочитанного Load, выделяются из арены документа,
+//а копии узлов - из обычной кучи
+using Array = std::pmr::vector<Node>;
+
+//словарь - вектор пар, упорядоченный по ключам: один блок памяти вместо узла на элемент.
+//Ключи выделяются из того же ресурса, что и вектор, у документа из Load - из его арены
+class Dict {
+public:
+    using value_type = std::pair<std::pmr::string, Node>;
+    using Storage = std::pmr::vector<value_type>;
+    using iterator = Storage::iterator;
+    using const_iterator = Storage::const_iterator;
+
+    Dict() = default;
+    explicit Dict(std::pmr::memory_resource* resource);
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_t size() const;
+    bool empty() const;
+    void reserve(size_t size);
+
+    iterator find(std::string_view key);
+    const_iterator find(std::string_view key) const;
+    size_t count(std::string_view key) const;
+    //out_of_range, если ключа нет
+    Node& at(std::string_view key);
+    const Node& at(std::string_view key) const;
+    //при повторе ключа остаётся первое значение, как у std::map
+    std::pair<iterator, bool> emplace(std::string_view key, Node value);
+
+    bool operator== (const Dict& other) const;
+    bool operator!= (const Dict& other) const {return !(*this == other);}
+
+private:
+    Storage items_;
+};
+
+//std::string_view - строка, которая ссылается на память документа: его сохранённый ввод или арену
+using NodeType = std::variant<std::nullptr_t, bool, int, double, std::string, Array, Dict, std::string_view>;
 const int TAB = 4;
 
 class ParsingError : public std::runtime_error {
@@ -29,19 +73,29 @@ public:
     Node(bool value);
     Node(const int value);
     Node(const double value);
-    Node(const std::string value);
-    Node(const Array array);
-    Node(const Dict map);
-
-    bool operator== (Node& other) const {return other.data_ == data_;}
-    bool operator!= (Node& other) const {return other.data_ != data_;}
-    bool operator== (const Node& other) const {return other.data_ == data_;}
-    bool operator!= (const Node& other) const {return other.data_ != data_;}
+    Node(std::string value);
+    Node(const char* value);
+    //строка по ссылке: value должна пережить узел
+    Node(std::string_view value);
+    Node(Array array);
+    Node(Dict map);
+
+    //копия узла владеет своими строками, даже если исходный узел на них ссылался
+    Node(const Node& other);
+    Node(Node&& other) = default;
+    Node& operator= (const Node& other);
+    Node& operator= (Node&& other) = default;
+
+    //строки сравниваются по содержимому, независимо от того, владеет ли узел строкой
+    bool operator== (Node& other) const {return *this == static_cast<const Node&>(other);}
+    bool operator!= (Node& other) const {return !(*this == other);}
+    bool operator== (const Node& other) const;
+    bool operator!= (const Node& other) const {return !(*this == other);}
     
     bool AsBool();
     int AsInt();
     double AsDouble();
-    std::string& AsString();
+    std::string_view AsString() const;
     Array& AsArray();
     Dict& AsMap();
 
@@ -50,7 +104,9 @@ public:
     bool IsInt() const {return std::holds_alternative<int>(data_);}
     bool IsDouble() const {return std::holds_alternative<double>(data_) || std::holds_alternative<int>(data_);}
     bool IsPureDouble() const {return std::holds_alternative<double>(data_);}
-    bool IsString() const {return std::holds_alternative<std::string>(data_);}
+    bool IsString() const {
+        return std::holds_alternative<std::string>(data_) || std::holds_alternative<std::string_view>(data_);
+    }
     bool IsArray() const {return std::holds_alternative<Array>(data_);}
     bool IsMap() const {return std::holds_alternative<Dict>(data_);}
 
@@ -64,6 +120,8 @@ class Document {
 public:
     Document() = default;
     explicit Document(Node root);
+    //root ссылается на память arena, она освобождается вместе с документом одним блоком
+    Document(Node root, std::unique_ptr<std::pmr::monotonic_buffer_resource> arena);
     Document& operator= (Document& other);
     Document& operator= (Node& other);
     Document& operator= (Document&& other);
@@ -74,11 +132,161 @@ public:
     bool operator== (const Document& other) const {return root_ == other.root_;}
     bool operator!= (const Document& other) const {return root_ != other.root_;}
 private:
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_; //объявлена раньше root_ и переживает его
     Node root_ = {};
 };
 
+//обработчик событий потокового разбора: документ передаётся по элементам, без построения дерева
+class Handler {
+public:
+    virtual void StartDict() = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    //key и строковое значение действительны только во время вызова,
+    //если ввод не сохраняется (Parse с keep_input)
+    virtual void Key(std::string_view key) = 0;
+    virtual void String(std::string_view value) = 0;
+    //null, bool, int или double
+    virtual void Value(Node value) = 0;
+    virtual ~Handler() = default;
+};
+
+//собирает дерево из событий разбора: элементы незакрытых контейнеров копятся в общих буферах,
+//закрытый контейнер выделяется из арены будущего документа сразу нужного размера.
+//Строковые узлы ссылаются на строки из String, если reference_strings (они должны жить
+//не меньше арены, как ввод, сохранённый в GetArena()), иначе на их копии в арене
+class NodeBuilder final : public Handler {
+public:
+    explicit NodeBuilder(bool reference_strings = false);
+    std::pmr::memory_resource* GetArena() {return arena_.get();}
+
+    void StartDict() override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Key(std::string_view key) override;
+    void String(std::string_view value) override;
+    void Value(Node value) override;
+    Document Build();
+
+private:
+    using Item = std::pair<std::string, Node>;
+
+    struct Frame {
+        bool is_dict;
+        size_t first;    //начало элементов контейнера в values_ или items_
+        std::string key; //ключ следующего значения Dict
+    };
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    bool reference_strings_;
+    std::vector<Frame> stack_;
+    std::vector<Node> values_;
+    std::vector<Item> items_; //ключи копируются в арену при закрытии словаря
+    Node root_;
+
+    void Add(Node value);
+};
+
+//печатает события Handler прямо в поток, без построения дерева. Вывод копится в буфере
+//и пишется в поток блоками, длинные строки - напрямую. indent_step = 0 - компактный вывод
+//без переводов строк и пробелов, indent - отступ, на котором начинается первое значение,
+//precision - значащих цифр в числах с плавающей точкой или numbers::SHORTEST
+class Writer final : public Handler {
+public:
+    explicit Writer(std::ostream& output, int indent_step = TAB, int indent = 0,
+                    int precision = numbers::DEFAULT_PRECISION);
+    Writer(const Writer&) = delete;
+    Writer& operator= (const Writer&) = delete;
+    ~Writer();
+
+    void StartDict() override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Key(std::string_view key) override;
+    void String(std::string_view value) override;
+    void Value(Node value) override;
+
+    void WriteNode(const Node& node);
+    //строковое значение по частям, каждая экранируется по мере записи
+    void StartString();
+    void StringPart(std::string_view part);
+    void EndString();
+    //уже напечатанное значение, например ответ, сохранённый раньше
+    void RawValue(std::string_view text);
+    void Flush();
+    //отбрасывает ещё не записанный в поток текст и незакрытые контейнеры,
+    //например после исключения посреди значения
+    void Reset();
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+    std::ostream& output_;
+    int indent_step_;
+    int indent_;
+    int precision_;
+    std::string buffer_;
+    std::string spaces_;
+    std::vector<bool> is_first_; //для каждого незакрытого контейнера: ещё нет элементов
+    bool after_key_ = false;
+
+    void WriteScalar(std::nullptr_t);
+    void WriteScalar(bool value);
+    void WriteScalar(int value);
+    void WriteScalar(double value);
+    void Write(std::string_view text);
+    void Put(char c);
+    void WriteIndent();
+    void NextItem();
+    void StartValue();
+    void Open();
+    void Close();
+};
+
+//поток, который пишет в writer одно строковое значение: то, что печатается в него
+//(например, SVG карты), экранируется и попадает в ответ без промежуточной строки.
+//Значение закрывается в деструкторе
+class StringStream final : private std::streambuf, public std::ostream {
+public:
+    explicit StringStream(Writer& writer);
+    ~StringStream();
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 12;
+
+    Writer& writer_;
+    char buffer_[BUFFER_SIZE];
+
+    int overflow(int c) override;
+    std::streamsize xsputn(const char* text, std::streamsize size) override;
+    int sync() override;
+};
+
+//поток читается блоками, в памяти не держится целиком
+void Parse(std::istream& input, Handler& handler);
+//блоки выделяются из keep_input и не переиспользуются: строки, переданные обработчику,
+//ссылаются на них и действительны, пока жив keep_input
+void Parse(std::istream& input, Handler& handler, std::pmr::memory_resource* keep_input);
+void Parse(std::string_view text, Handler& handler);
+
+//Двухпроходный разбор для многоядерных машин: по тексту строится структурный индекс
+//(позиции скобок, запятых, двоеточий и кавычек), затем большие массивы в корне документа
+//и в корневом контейнере делятся по границам элементов и разбираются параллельно.
+//Обработчик получает те же события в том же порядке, что и от Parse. На одном ядре
+//это обычный Parse. Иначе поток читается в память целиком, и к нему добавляется индекс
+//по 4 байта на структурный символ, поэтому потоковый Parse остаётся основным способом
+void ParseParallel(std::string_view text, Handler& handler);
+void ParseParallel(std::istream& input, Handler& handler);
+
+//строковые узлы ссылаются на ввод, сохранённый в арене документа
 Document Load(std::istream& input);
+//разбирается через ParseParallel
+Document Load(std::string_view text);
 
 void Print(Document& doc, std::ostream& output);
+//печатает узел, вложенный на indent пробелов, без отступа перед первой строкой
+void Print(const Node& node, std::ostream& output, int indent);
 
 }  // namespace json
\ No newline at end of file
@@ -59,11 +59,11 @@ namespace json {
             throw logic_error("Not have container from Value"s);
         }
         if (stack_.back()->IsArray()) {
-            const_cast<Array&>(get<Array>(stack_.back()->GetValue())).emplace_back(value);
+            const_cast<Array&>(get<Array>(stack_.back()->GetValue())).emplace_back(move(value));
             return *this;
         }
         if (stack_.back()->IsMap() && key_.is_value) {
-            const_cast<Dict&>(get<Dict>(stack_.back()->GetValue())).emplace(key_.value, value);
+            const_cast<Dict&>(get<Dict>(stack_.back()->GetValue())).emplace(move(key_.value), move(value));
             key_.is_value = false;
             return *this;
         }
@@ -91,13 +91,13 @@ namespace json {
         }
         if (stack_.back()->IsArray()) {
             auto& array = const_cast<Array&>(get<Array>(stack_.back()->GetValue()));
-            array.emplace_back(node);
+            array.emplace_back(move(node));
             stack_.push_back(&array.back());
             return true;
         }
         if (stack_.back()->IsMap() && key_.is_value) {
             auto& dict = const_cast<Dict&>(get<Dict>(stack_.back()->GetValue()));
-            auto it = dict.emplace(key_.value, node).first;
+            auto it = dict.emplace(move(key_.value), move(node)).first;
             key_.is_value = false;
             stack_.push_back(&(it->second));
             return true;
@@ -4,8 +4,197 @@ namespace tr_cat {
     namespace interface {
         using namespace std;
 
+//base_requests не собирается в дерево: запрос остановки или автобуса копится в RequestsHandler
+//и передаётся в ReadStop/ReadBus, как только закрылся его словарь
+        class JsonReader::RequestsHandler final : public json::Handler {
+        public:
+            explicit RequestsHandler(JsonReader& reader)
+            :reader_(reader) {}
+
+            void StartDict() override {
+                if (!in_base_) {
+                    ++depth_;
+                    document_.StartDict();
+                    return;
+                }
+                if (base_depth_ == 0) {
+                    throw invalid_argument("base_requests must be an array"s);
+                }
+                if (base_depth_ == 1) {
+                    element_.Clear();
+                } else if (base_depth_ != 2 || field_ != Field::ROAD_DISTANCES) {
+                    field_ = Field::OTHER;
+                }
+                ++base_depth_;
+            }
+
+            void EndDict() override {
+                if (!in_base_) {
+                    --depth_;
+                    document_.EndDict();
+                    return;
+                }
+                if (--base_depth_ == 1) {
+                    AddElement();
+                }
+            }
+
+            void StartArray() override {
+                if (!in_base_) {
+                    ++depth_;
+                    document_.StartArray();
+                    return;
+                }
+                if (base_depth_ == 1) {
+                    throw invalid_argument("Invalid base request"s);
+                }
+                if (base_depth_ != 0 && (base_depth_ != 2 || field_ != Field::STOPS)) {
+                    field_ = Field::OTHER;
+                }
+                ++base_depth_;
+            }
+
+            void EndArray() override {
+                if (!in_base_) {
+                    --depth_;
+                    document_.EndArray();
+                    return;
+                }
+                if (--base_depth_ == 0) {
+                    in_base_ = false;
+                }
+            }
+
+            void Key(string_view key) override {
+                if (!in_base_) {
+                    if (depth_ == 1 && key == "base_requests"sv) {
+                        in_base_ = true;
+                        return;
+                    }
+                    document_.Key(key);
+                    return;
+                }
+                if (base_depth_ == 2) {
+                    field_ = ToField(key);
+                } else if (base_depth_ == 3 && field_ == Field::ROAD_DISTANCES) {
+                    distance_to_ = reader_.InternName(key);
+                }
+            }
+
+            void String(string_view value) override {
+                if (!in_base_) {
+                    document_.String(value);
+                    return;
+                }
+                CheckValue();
+                if (base_depth_ == 2 && field_ == Field::TYPE) {
+                    element_.type = value;
+                } else if (base_depth_ == 2 && field_ == Field::NAME) {
+                    element_.name = value;
+                } else if (base_depth_ == 3 && field_ == Field::STOPS) {
+                    element_.stops.push_back(reader_.InternName(value));
+                }
+            }
+
+            void Value(json::Node value) override {
+                if (!in_base_) {
+                    document_.Value(move(value));
+                    return;
+                }
+                CheckValue();
+                if (base_depth_ == 2 && field_ == Field::LATITUDE) {
+                    element_.latitude = value.AsDouble();
+                } else if (base_depth_ == 2 && field_ == Field::LONGITUDE) {
+                    element_.longitude = value.AsDouble();
+                } else if (base_depth_ == 2 && field_ == Field::IS_ROUNDTRIP) {
+                    element_.is_ring = value.AsBool();
+                } else if (base_depth_ == 3 && field_ == Field::ROAD_DISTANCES) {
+                    element_.distances.emplace_back(distance_to_, value.AsInt());
+                }
+            }
+
+            json::Document Build() {
+                return document_.Build();
+            }
+
+        private:
+            enum class Field {TYPE, NAME, LATITUDE, LONGITUDE, ROAD_DISTANCES, STOPS, IS_ROUNDTRIP, OTHER};
+
+            //поля текущего запроса, ключи могут идти в любом порядке
+            struct Element {
+                string type;
+                string name;
+                optional<double> latitude;
+                optional<double> longitude;
+                //названия из InternName: остановка копируется один раз за весь ввод
+                vector<pair<string_view, int>> distances;
+                vector<string_view> stops;
+                optional<bool> is_ring;
+
+                void Clear() {
+                    type.clear();
+                    name.clear();
+                    latitude.reset();
+                    longitude.reset();
+                    distances.clear();
+                    stops.clear();
+                    is_ring.reset();
+                }
+            };
+
+            JsonReader& reader_;
+            json::NodeBuilder document_;
+            int depth_ = 0;         //вложенность вне base_requests
+            bool in_base_ = false;
+            int base_depth_ = 0;    //вложенность внутри base_requests: 1 - массив, 2 - запрос
+            Field field_ = Field::OTHER;
+            string_view distance_to_;
+            Element element_;
+
+            static Field ToField(string_view key) {
+                static const unordered_map<string_view, Field> fields = {
+                    {"type"sv, Field::TYPE}, {"name"sv, Field::NAME}, {"latitude"sv, Field::LATITUDE},
+                    {"longitude"sv, Field::LONGITUDE}, {"road_distances"sv, Field::ROAD_DISTANCES},
+                    {"stops"sv, Field::STOPS}, {"is_roundtrip"sv, Field::IS_ROUNDTRIP}};
+                auto it = fields.find(key);
+                return it == fields.end() ? Field::OTHER : it->second;
+            }
+
+            //base_requests - массив словарей
+            void CheckValue() const {
+                if (base_depth_ < 2) {
+                    throw invalid_argument("Invalid base request"s);
+                }
+            }
+
+            void AddElement() {
+                if (element_.type == "Stop"s) {
+                    if (!element_.latitude || !element_.longitude) {
+                        throw invalid_argument("Stop without coordinates: "s + element_.name);
+                    }
+                    const StopId stop = reader_.ReadStop(element_.name, {*element_.latitude, *element_.longitude});
+                    for (const auto& [name, distance] : element_.distances) {
+                        reader_.ReadDistance(stop, name, distance);
+                    }
+                } else if (element_.type == "Bus"s) {
+                    if (!element_.is_ring) {
+                        throw invalid_argument("Bus without is_roundtrip: "s + element_.name);
+                    }
+                    reader_.ReadBus(element_.name, element_.stops, *element_.is_ring);
+                } else {
+                    throw invalid_argument ("Unknown type"s);
+                }
+            }
+        };
+
         void JsonReader::ReadDocument() {
-            document_ = json::Load(input_);
+            RequestsHandler handler(*this);
+            if (parallel_parsing_) {
+                json::ParseParallel(input_, handler);
+            } else {
+                json::Parse(input_, handler);
+            }
+            document_ = handler.Build();
         }
 
         void JsonReader::ParseDocument() {
@@ -13,9 +202,6 @@ namespace tr_cat {
                 return;
             }
             auto& it = document_.GetRoot().AsMap();
-            if (it.count ("base_requests"s)){
-                ParseBase(it.at("base_requests"s));
-            }
             if (it.count("stat_requests"s) && (it.at("stat_requests"s).IsArray())) {
                 ParseStats(it.at("stat_requests"s));
             }
@@ -27,51 +213,40 @@ namespace tr_cat {
                 ParseRoutingSettings(it.at("routing_settings"s));
             }
 
-            if (it.count ("serialization_settings"s)) {
-                serializator_.SetPathToSerialize(it.at("serialization_settings"s)
-                                    .AsMap().at ("file"s).AsString());
+            if (it.count("output_settings"s)) {
+                auto& settings = it.at("output_settings"s).AsMap();
+                if (settings.count("compact"s) && settings.at("compact"s).AsBool()) {
+                    indent_step_ = 0;
+                }
+                if (settings.count("precision"s)) {
+                    precision_ = ReadPrecision(settings.at("precision"s));
+                }
             }
 
-        }
-//-----------------------Parse Base------------------------------------
-        void JsonReader::ParseBase(json::Node& base_node) {
-
-            auto& base = base_node.AsArray();
-            for (auto& element_node: base) {
-                auto& element = element_node.AsMap();
-                if (element.at("type"s).AsString() == "Stop"s) {
-
-                    stops_.push_back({});
-
-                    stops_.back().name = element.at("name"s).AsString();
-                    stops_.back().coordinates.lat = element.at("latitude"s).AsDouble();
-                    stops_.back().coordinates.lng = element.at("longitude"s).AsDouble();
-
-                    if (element.count("road_distances"s)) {
-                        auto& map_distances = element.at("road_distances"s).AsMap();
-                        for (auto& [name, value] : map_distances) {
-                            distances_[stops_.back().name].push_back({name, value.AsInt()});
-                        }
+            if (it.count ("serialization_settings"s)) {
+                auto& settings = it.at("serialization_settings"s).AsMap();
+                serializator_.SetPathToSerialize(settings.at ("file"s).AsString());
+                if (settings.count("parent"s)) {
+                    serializator_.SetParentPath(settings.at("parent"s).AsString());
+                }
+                if (settings.count("route_cache"s)) {
+                    const int size = settings.count("route_cache_size"s) ? settings.at("route_cache_size"s).AsInt()
+                                                                         : DEFAULT_ROUTE_CACHE_SIZE;
+                    if (size < 0) {
+                        throw invalid_argument("invalid route_cache_size"s);
                     }
-
-                } else if (element.at("type"s).AsString() == "Bus"s) {
-                    
-                    buses_.push_back({});
-
-                    buses_.back().name = element.at("name"s).AsString();
-                    buses_.back().is_ring = element.at("is_roundtrip"s).AsBool();
-
-                    auto& it = element.at("stops"s).AsArray();
-                    buses_.back().stops.reserve(it.size());
-                    for (json::Node& elem : it) {
-                        buses_.back().stops.push_back(elem.AsString());
+                    serializator_.SetRouteCache(settings.at("route_cache"s).AsString(), static_cast<size_t>(size));
+                }
+                if (settings.count("format"s)) {
+                    const string_view format = settings.at("format"s).AsString();
+                    if (format == "flat"s) {
+                        serializator_.SetFormat(serialize::BaseFormat::FLAT);
+                    } else if (format != "protobuf"s) {
+                        throw invalid_argument("Unknown base format"s);
                     }
-
-                } else {
-                    throw invalid_argument ("Unknown type"s);
                 }
-
             }
+
         }
 //------------------------------Parse Stats---------------------------
         void JsonReader::ParseStats(json::Node& stats_node) {
@@ -80,27 +255,30 @@ namespace tr_cat {
             stats_.reserve(stats.size());
 
             for (auto& element_node : stats) {
-                auto& element = element_node.AsMap();
-                const string& type = element.at("type"s).AsString();
-                if ((type == "Bus"s) || (type == "Stop"s)) {
-                    stats_.push_back({element.at("id"s).AsInt(), 
-                                      type, 
-                                      element.at("name"s).AsString(),
-                                      "", ""});
-                } else if (type == "Map"s) {
-                    stats_.push_back({element.at("id"s).AsInt(), 
-                                      type, "", "", ""sv});
-                } else if (type == "Route"s) {
-                    stats_.push_back({element.at("id"s).AsInt(), 
-                                      type, "",
-                                      element.at("from"s).AsString(),
-                                      element.at("to"s).AsString()});
-                } else {
-                    throw invalid_argument("Unknown type"s);
-                }
+                stats_.push_back(ParseStat(element_node));
             }
         }
 
+        JsonReader::Stat JsonReader::ParseStat(json::Node& stat_node) {
+            auto& element = stat_node.AsMap();
+            const string_view type = element.at("type"s).AsString();
+            if ((type == "Bus"s) || (type == "Stop"s)) {
+                return {element.at("id"s).AsInt(), 
+                        type, 
+                        element.at("name"s).AsString(),
+                        "", ""};
+            } else if (type == "Map"s) {
+                return {element.at("id"s).AsInt(), 
+                        type, "", "", ""sv};
+            } else if (type == "Route"s) {
+                return {element.at("id"s).AsInt(), 
+                        type, "",
+                        element.at("from"s).AsString(),
+                        element.at("to"s).AsString()};
+            }
+            throw invalid_argument("Unknown type"s);
+        }
+
 //-----------------------------Parse Render Settings--------------------------------------
         void JsonReader::ParseRenderSettings(json::Node& settings_node) {
 
@@ -139,7 +317,7 @@ namespace tr_cat {
 
             auto get_color = [&] (json::Node& key, svg::Color* field) {
                 if (key.IsString()) {
-                    *field = key.AsString();
+                    *field = string(key.AsString());
                 } else if (key.AsArray().size() == 3) {
                     *field = svg::Rgb({key.AsArray()[0].AsInt(), key.AsArray()[1].AsInt(), key.AsArray()[2].AsInt()});
                 } else if (key.AsArray().size() == 4) {
@@ -163,9 +341,20 @@ namespace tr_cat {
                     get_color(node, &render_settings.color_palette.back());
                 }
             }
+            if (settings.count("precision"s)) {
+                render_settings.precision = ReadPrecision(settings.at("precision"s));
+            }
             renderer_.SetRenderSettings(move(render_settings));
         }
 
+        int JsonReader::ReadPrecision(json::Node& precision) {
+            const int value = precision.AsInt();
+            if (!numbers::IsValidPrecision(value)) {
+                throw invalid_argument("invalid precision"s);
+            }
+            return value;
+        }
+
 //------------------------------Parse Routing Settings-----------------------------
         void JsonReader::ParseRoutingSettings (json::Node& routing_settings) {
 
@@ -181,83 +370,222 @@ namespace tr_cat {
         }
 
 //--------------------------------------Print--------------------------------------
-        void JsonReader::PrepareToPrint() {
-            json::Builder builder;
-            builder.StartArray();
+//ответы печатаются в json::Writer по мере вычисления, без построения дерева. Ответы Bus и Stop
+//зависят только от базы, поэтому ответ на каждый автобус и остановку печатается один раз,
+//а на повторные запросы копируется с подстановкой request_id
+        void JsonReader::PrintAnswers() {
+            json::Writer writer(output_, indent_step_, 0, precision_);
+            bus_fragments_.resize(GetCatalog().GetBuses().size());
+            stop_fragments_.resize(GetCatalog().GetStops().size());
+            writer.StartArray();
             for (auto& answer : answers_) {
-                builder.Value(visit(CreateNode{renderer_, transport_router_}, answer));
+                PrintAnswer(answer, writer);
             }
-            builder.EndArray();
-            document_answers_ = builder.Build();
-        }  
+            writer.EndArray();
+            writer.Flush();
+            output_ << endl;
+        }
 
-        void JsonReader::PrintAnswers() {
-            PrepareToPrint();
-            json::Print(document_answers_, output_);
+//построчный режим: первая непустая строка - документ с настройками, как у process_requests
+//(его stat_requests тоже обрабатываются), каждая следующая - один запрос из stat_requests.
+//Ответ печатается компактно отдельной строкой и сбрасывается в поток сразу, не дожидаясь
+//остальных запросов. Ошибка в запросе не прерывает обработку: вместо ответа печатается
+//{"error_message": текст ошибки, "request_id": id}, id - если его удалось прочитать
+        void JsonReader::ProcessLines() {
+            string line;
+            while (line.find_first_not_of(" \t\r"sv) == string::npos) {
+                if (!getline(input_, line)) {
+                    return;
+                }
+            }
+            document_ = json::Load(string_view(line));
+            ParseDocument();
+            Deserialize(true);
+            indent_step_ = 0;
+
+            json::Writer writer(output_, 0, 0, precision_);
+            bus_fragments_.resize(GetCatalog().GetBuses().size());
+            stop_fragments_.resize(GetCatalog().GetStops().size());
+            auto print_line = [this, &writer](Answer answer) {
+                PrintAnswer(answer, writer);
+                writer.Flush();
+                output_ << endl;
+            };
+            auto print_error = [this, &writer](const exception& error, optional<int> id) {
+                writer.Reset();
+                writer.StartDict();
+                writer.Key("error_message"sv);
+                writer.String(error.what());
+                if (id) {
+                    writer.Key("request_id"sv);
+                    writer.Value(*id);
+                }
+                writer.EndDict();
+                writer.Flush();
+                output_ << endl;
+            };
+            for (const Stat& stat : stats_) {
+                try {
+                    print_line(GetAnswer(stat));
+                } catch (const exception& error) {
+                    print_error(error, stat.id);
+                }
+            }
+            stats_ = {};
+            document_ = json::Document{};
+
+            while (getline(input_, line)) {
+                if (line.find_first_not_of(" \t\r"sv) == string::npos) {
+                    continue;
+                }
+                optional<int> id;
+                try {
+                    //строка короткая, структурный индекс Load(string_view) для неё не нужен
+                    json::NodeBuilder builder;
+                    json::Parse(string_view(line), builder);
+                    json::Document request = builder.Build();
+                    json::Node& root = request.GetRoot();
+                    if (root.IsMap() && root.AsMap().count("id"sv) && root.AsMap().at("id"sv).IsInt()) {
+                        id = root.AsMap().at("id"sv).AsInt();
+                    }
+                    print_line(GetAnswer(ParseStat(root)));
+                } catch (const exception& error) {
+                    print_error(error, id);
+                }
+            }
+            SaveRouteCache();
         }
 
-//-----------------------------CreateNode-----------------------------------
+        void JsonReader::PrintAnswer(Answer& answer, json::Writer& writer) {
+            auto print_fragment = [this, &writer](std::optional<Fragment>& fragment, int id, auto output) {
+                if (!fragment) {
+                    output.id = 0;
+                    fragment = MakeFragment(output);
+                }
+                fragment_text_ = fragment->prefix;
+                fragment_text_ += to_string(id);
+                fragment_text_ += fragment->suffix;
+                writer.RawValue(fragment_text_);
+            };
+            if (BusOutput* bus = get_if<BusOutput>(&answer)) {
+                print_fragment(bus_fragments_[bus->bus->id], bus->id, *bus);
+            } else if (StopOutput* stop = get_if<StopOutput>(&answer)) {
+                print_fragment(stop_fragments_[stop->stop->id], stop->id, *stop);
+            } else {
+                visit(AnswerWriter{GetCatalog(), renderer_, transport_router_, serializator_, writer}, answer);
+            }
+        }
+
+        template <typename Output>
+        JsonReader::Fragment JsonReader::MakeFragment(Output& answer) {
+            ostringstream out;
+            {
+                //ответ печатается с тем же отступом, что и элемент массива ответов
+                json::Writer writer(out, indent_step_, indent_step_, precision_);
+                AnswerWriter{GetCatalog(), renderer_, transport_router_, serializator_, writer}(answer);
+            }
+            const string text = move(out).str();
+            //кавычки в строковых значениях экранируются, поэтому такая подстрока - только ключ
+            const string_view key = indent_step_ ? "\"request_id\": 0"sv : "\"request_id\":0"sv;
+            const size_t pos = text.find(key);
+            if (pos == string::npos) {
+                throw logic_error("Answer without request_id"s);
+            }
+            return {text.substr(0, pos + key.size() - 1), text.substr(pos + key.size())};
+        }
+
+//-----------------------------AnswerWriter-----------------------------------
 
+//ключи печатаются по алфавиту, как их печатал json::Dict
 //если ошибка, передаём только id запроса, текст ошибки одинаковый, для любого неудачного запроса
-        json::Node JsonReader::CreateNode::operator() (int value) {
-            json::Builder builder;
-            return builder.StartDict()  .Key("request_id"s).Value(value)
-                                        .Key("error_message"s).Value("not found"s).EndDict().Build();
+        void JsonReader::AnswerWriter::operator() (int value) {
+            writer_.StartDict();
+            writer_.Key("error_message"sv);
+            writer_.String("not found"sv);
+            writer_.Key("request_id"sv);
+            writer_.Value(value);
+            writer_.EndDict();
         }
 
-        json::Node JsonReader::CreateNode::operator() (StopOutput& value) {
-            json::Builder builder;
-            builder.StartDict().Key("request_id"s).Value(value.id)
-                                 .Key("buses"s).StartArray();
-            for (string_view bus : value.stop->buses) {
-                builder.Value(static_cast<string>(bus));
+        void JsonReader::AnswerWriter::operator() (StopOutput& value) {
+            writer_.StartDict();
+            writer_.Key("buses"sv);
+            writer_.StartArray();
+            for (BusId bus : catalog_.GetStopBuses(value.stop->id)) {
+                writer_.String(catalog_.GetBus(bus).name);
             }
-            return builder.EndArray().EndDict().Build();
+            writer_.EndArray();
+            writer_.Key("request_id"sv);
+            writer_.Value(value.id);
+            writer_.EndDict();
         }
 
-        json::Node JsonReader::CreateNode::operator() (BusOutput& value) {
-            json::Builder builder;
-            return builder.StartDict()  .Key("request_id"s).Value(value.id)
-                                        .Key("curvature"s).Value(value.bus->curvature)
-                                        .Key("route_length"s).Value(static_cast<double>(value.bus->distance))
-                                        .Key("stop_count"s).Value(static_cast<int>(value.bus->stops.size()))
-                                        .Key("unique_stop_count"s).Value(value.bus->unique_stops).EndDict().Build();
+        void JsonReader::AnswerWriter::operator() (BusOutput& value) {
+            writer_.StartDict();
+            writer_.Key("curvature"sv);
+            writer_.Value(value.bus->curvature);
+            writer_.Key("request_id"sv);
+            writer_.Value(value.id);
+            writer_.Key("route_length"sv);
+            writer_.Value(static_cast<double>(value.bus->distance));
+            writer_.Key("stop_count"sv);
+            writer_.Value(static_cast<int>(value.bus->GetStopCount()));
+            writer_.Key("unique_stop_count"sv);
+            writer_.Value(value.bus->unique_stops);
+            writer_.EndDict();
         }
 
-        json::Node JsonReader::CreateNode::operator() (MapOutput& value) {
-            json::Builder builder;
-            ostringstream output;
-            renderer_.Render(output);
-
-            return builder.StartDict().Key("request_id"s).Value(value.id)
-                                      .Key("map"s).Value(output.str()).EndDict().Build();
+        void JsonReader::AnswerWriter::operator() (MapOutput& value) {
+            serializator_.LoadRenderer();
+            writer_.StartDict();
+            writer_.Key("map"sv);
+            {
+                json::StringStream map(writer_);
+                renderer_.Render(map);
+            }
+            writer_.Key("request_id"sv);
+            writer_.Value(value.id);
+            writer_.EndDict();
         }
 
-        json::Node JsonReader::CreateNode::operator() (RouteOutput& value) {
+        void JsonReader::AnswerWriter::operator() (RouteOutput& value) {
 
-            std::optional<router::CompletedRoute> result = transport_router_.ComputeRoute(value.from->vertex_id, 
-                                                                   value.to->vertex_id);
-            json::Builder builder;
+            const std::optional<router::CompletedRoute>& result = serializator_.FindRoute(value.from->id, value.to->id);
             if (!result) {
-                return builder.StartDict().Key("request_id"s).Value(value.id)
-                                          .Key("error_message"s).Value("not found"s).EndDict().Build();
+                (*this)(value.id);
+                return;
             }
 
-            builder.StartDict().Key("request_id"s).Value(value.id)
-                               .Key("total_time"s).Value(result->total_time)
-                               .Key("items"s).StartArray();
-
+            writer_.StartDict();
+            writer_.Key("items"sv);
+            writer_.StartArray();
             for (const router::CompletedRoute::Line& line : result->route) {
-                builder.StartDict() .Key("stop_name"s).Value(line.stop->name)
-                                    .Key("time"s).Value(line.wait_time)
-                                    .Key("type"s).Value("Wait"s).EndDict()
-                       .StartDict() .Key("bus"s).Value(line.bus->name)
-                                    .Key("span_count"s).Value(static_cast<int>(line.count_stops))
-                                    .Key("time"s).Value(line.run_time)
-                                    .Key("type").Value("Bus"s).EndDict();
-            }
-            builder.EndArray().EndDict();
-            return builder.Build();
+                writer_.StartDict();
+                writer_.Key("stop_name"sv);
+                writer_.String(line.stop->name);
+                writer_.Key("time"sv);
+                writer_.Value(line.wait_time);
+                writer_.Key("type"sv);
+                writer_.String("Wait"sv);
+                writer_.EndDict();
+
+                writer_.StartDict();
+                writer_.Key("bus"sv);
+                writer_.String(line.bus->name);
+                writer_.Key("span_count"sv);
+                writer_.Value(static_cast<int>(line.count_stops));
+                writer_.Key("time"sv);
+                writer_.Value(line.run_time);
+                writer_.Key("type"sv);
+                writer_.String("Bus"sv);
+                writer_.EndDict();
+            }
+            writer_.EndArray();
+            writer_.Key("request_id"sv);
+            writer_.Value(value.id);
+            writer_.Key("total_time"sv);
+            writer_.Value(result->total_time);
+            writer_.EndDict();
         }
 
         bool NodeCompare(json::Node lhs, json::Node rhs) {
@@ -280,8 +608,8 @@ namespace tr_cat {
                 return true;
             }
             if (lhs.IsString() && rhs.IsString()) {
-                string lhs_s = lhs.AsString();
-                string rhs_s = rhs.AsString();
+                string lhs_s(lhs.AsString());
+                string rhs_s(rhs.AsString());
                 for (auto it = lhs_s.find(' '); it != string::npos; it = lhs_s.find(' ')) {
                     lhs_s.erase(it, 1);
                 }
@@ -4,7 +4,6 @@
 #include "transport_catalogue.h"
 #include "request_handler.h"
 #include "map_renderer.h"
-#include "json_builder.h"
 #include "transport_router.h"
 #include "serialization.h"
 
@@ -16,6 +15,7 @@
 
 namespace tr_cat {
 namespace interface {
+
 class JsonReader : public RequestInterface {
 public:
 
@@ -43,40 +43,77 @@ public:
         , renderer_(catalog)
         , serializator_(catalog, renderer_, transport_router_){}
 
+    //ReadDocument читает ввод целиком и разбирает большие массивы в несколько потоков (json::ParseParallel);
+    //по умолчанию ввод разбирается потоково и в памяти целиком не держится
+    void SetParallelParsing(bool parallel) {parallel_parsing_ = parallel;}
     void ReadDocument () override;
     void ParseDocument () override;
     bool Serialize(bool with_graph = false) const override {return serializator_.Serialize(with_graph);}
-    bool Deserialize(bool with_graph = false) override {return serializator_.Deserialize(with_graph); }
-    void RenderMap(std::ostream& out = std::cout) override {renderer_.Render(out);}
+    bool Deserialize(bool with_graph = false) override {
+        const bool result = serializator_.Deserialize(with_graph);
+        serializator_.LoadRouteCache();
+        return result;
+    }
+    bool SaveRouteCache() override {return serializator_.SaveRouteCache();}
+    void RenderMap(std::ostream& out = std::cout) override {
+        serializator_.LoadRenderer();
+        renderer_.Render(out);
+    }
     void CreateGraph() override {transport_router_.CreateGraph();}
     void PrintAnswers () override;
+    //process_requests --ndjson: запросы и ответы по одному на строку, см. json_reader.cpp
+    void ProcessLines ();
     bool TestingFilesOutput(std::string filename_lhs, std::string filename_rhs) override;
     const render::RenderSettings& GetRenderSettings() const;
 private:
-    struct CreateNode {
+    //разбирает base_requests потоково, остальное собирает в document_
+    class RequestsHandler;
+
+    //печатает ответ событиями writer
+    struct AnswerWriter {
         friend class JsonReader;
-        explicit CreateNode(render::MapRenderer& renderer, router::TransportRouter& router)
-        :renderer_(renderer), transport_router_(router){}
-        json::Node operator() (int value);
-        json::Node operator() (StopOutput& value);
-        json::Node operator() (BusOutput& value);
-        json::Node operator() (MapOutput& value);
-        json::Node operator() (RouteOutput& value);
+        explicit AnswerWriter(const aggregations::TransportCatalogue& catalog,
+                              render::MapRenderer& renderer, router::TransportRouter& router,
+                              serialize::Serializator& serializator, json::Writer& writer)
+        :catalog_(catalog), renderer_(renderer), transport_router_(router), serializator_(serializator)
+        , writer_(writer){}
+        void operator() (int value);
+        void operator() (StopOutput& value);
+        void operator() (BusOutput& value);
+        void operator() (MapOutput& value);
+        void operator() (RouteOutput& value);
     private:
+        const aggregations::TransportCatalogue& catalog_;
         render::MapRenderer& renderer_;
         router::TransportRouter& transport_router_;
+        serialize::Serializator& serializator_; //догружает из базы маршрутизатор и настройки карты
+        json::Writer& writer_;
+    };
+    //напечатанный ответ Bus или Stop без значения request_id: prefix, request_id, suffix
+    struct Fragment {
+        std::string prefix;
+        std::string suffix;
     };
     json::Document document_ = {};
-    json::Document document_answers_ = {};
+    int indent_step_ = json::TAB; //0 - компактный вывод ответов, output_settings.compact
+    int precision_ = numbers::DEFAULT_PRECISION; //значащих цифр в ответах, output_settings.precision
+    bool parallel_parsing_ = false;
+    std::vector<std::optional<Fragment>> bus_fragments_;
+    std::vector<std::optional<Fragment>> stop_fragments_;
+    std::string fragment_text_; //буфер ответа, собранного из Fragment
     router::TransportRouter transport_router_;
     render::MapRenderer renderer_;
     serialize::Serializator serializator_;
 
-    void ParseBase (json::Node& base);
     void ParseStats (json::Node& stats);
+    static Stat ParseStat(json::Node& stat);
     void ParseRenderSettings(json::Node& render_settings);
     void ParseRoutingSettings(json::Node& routing_settings);
-    void PrepareToPrint ();
+    //число значащих цифр или 0 - кратчайшая запись, которая читается обратно в то же число
+    static int ReadPrecision(json::Node& precision);
+    void PrintAnswer(Answer& answer, json::Writer& writer);
+    template <typename Output>
+    Fragment MakeFragment(Output& answer);
 
 };
 } //interface
@@ -1,6 +1,7 @@
 #include "transport_catalogue.h"
 #include "request_handler.h"
 #include "json_reader.h"
+#include "proto_reader.h"
 
 #include <cassert>
 #include <fstream>
@@ -10,35 +11,60 @@ using namespace std;
 using namespace tr_cat;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base [--parallel]|process_requests [--parallel|--ndjson|--protobuf]]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc != 2 && argc != 3) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
+    const std::string_view option = argc == 3 ? argv[2] : ""sv;
+    //ввод читается в память целиком, большие массивы запросов разбираются в несколько потоков
+    const bool parallel = option == "--parallel"sv;
+    //запросы и ответы по одному на строку, ответ печатается сразу
+    const bool ndjson = option == "--ndjson"sv;
+    //запросы и ответы в двоичном протоколе из requests.proto
+    const bool protobuf = option == "--protobuf"sv;
+    if (argc == 3 && !parallel && !((ndjson || protobuf) && mode == "process_requests"sv)) {
+        PrintUsage();
+        return 1;
+    }
 
     if (mode == "make_base"sv) {
         aggregations::TransportCatalogue catalog;
         interface::JsonReader reader(catalog);
+        reader.SetParallelParsing(parallel);
         reader.ReadDocument ();
         reader.ParseDocument ();
-        reader.AddStops ();
         reader.AddDistances ();
         reader.AddBuses ();
         reader.CreateGraph();
         reader.Serialize (true);
+    } else if (mode == "process_requests"sv && ndjson) {
+        aggregations::TransportCatalogue catalog;
+        interface::JsonReader reader(catalog);
+        reader.ProcessLines ();
+    } else if (mode == "process_requests"sv && protobuf) {
+        aggregations::TransportCatalogue catalog;
+        interface::ProtoReader reader(catalog);
+        reader.ReadDocument ();
+        reader.ParseDocument ();
+        reader.Deserialize (true);
+        reader.ProcessRequests ();
+        reader.SaveRouteCache ();
     } else if (mode == "process_requests"sv) {
         aggregations::TransportCatalogue catalog;
         interface::JsonReader reader(catalog);
+        reader.SetParallelParsing(parallel);
         reader.ReadDocument ();
         reader.ParseDocument ();
         reader.Deserialize (true);
         reader.GetAnswers ();
         reader.PrintAnswers ();
+        reader.SaveRouteCache ();
     } else {
         PrintUsage();
         return 1;
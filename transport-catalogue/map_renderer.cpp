@@ -1,5 +1,7 @@
 #include "map_renderer.h"
 
+#include <sstream>
+
 namespace tr_cat {
 namespace render {
 
@@ -13,7 +15,25 @@ enum class ColorVariant {
     RGBA
 };
 
+//карта, которой нет в базе, рисуется прямо в out и не сохраняется
 void MapRenderer::Render(ostream& out) {
+    if (rendered_map_) {
+        out << *rendered_map_;
+        return;
+    }
+    Draw(out);
+}
+
+const string& MapRenderer::GetRenderedMap() {
+    if (!rendered_map_) {
+        ostringstream out;
+        Draw(out);
+        rendered_map_ = move(out).str();
+    }
+    return *rendered_map_;
+}
+
+void MapRenderer::Draw(ostream& out) {
     Document doc_to_render;
     auto coords = CollectCoordinates();
     SphereProjector project (coords.begin(), coords.end(), settings_.width, settings_.height, settings_.padding);
@@ -21,7 +41,7 @@ void MapRenderer::Render(ostream& out) {
     set<string_view> stops_in_buses = RenderBuses(project, doc_to_render);
     RenderStops(project, doc_to_render, stops_in_buses);
 
-    doc_to_render.Render(out);
+    doc_to_render.Render(out, settings_.precision);
 }
 
 RenderSettings MapRenderer::GetSettings() {
@@ -32,15 +52,19 @@ RenderSettings& MapRenderer::GetSettingsRef() {
     return settings_;
 }
 
-unordered_set<geo::Coordinates, CoordinatesHasher> MapRenderer::CollectCoordinates () const {
-    unordered_set<geo::Coordinates, CoordinatesHasher> result;
+vector<geo::Coordinates> MapRenderer::CollectCoordinates () const {
+    vector<geo::Coordinates> result;
+    vector<bool> is_collected(catalog_.GetVertexCount(), false);
     for (string_view bus_name : catalog_) {
         optional<const Bus*> bus_finded = catalog_.GetBusInfo(bus_name);
         if (!bus_finded) {
             throw logic_error("Catalog error. No Bus info"s + static_cast<string> (bus_name));
         }
-        for (const Stop* stop : (*bus_finded)->stops) {
-            result.insert(stop->coordinates);
+        for (StopId stop : (*bus_finded)->stops) {
+            if (!is_collected[stop]) {
+                is_collected[stop] = true;
+                result.push_back(catalog_.GetStop(stop).GetCoordinates());
+            }
         }
     }
     return result;
@@ -49,13 +73,13 @@ unordered_set<geo::Coordinates, CoordinatesHasher> MapRenderer::CollectCoordinat
 pair<unique_ptr<Text>, unique_ptr<Text>> MapRenderer::AddBusLabels(SphereProjector& project, int index_color,
                                                                 const Stop* stop, string_view name) {
     Text bus_name_underlabel, bus_name_label;
-    bus_name_underlabel.SetData(static_cast<string>(name)).SetPosition(project(stop->coordinates))
+    bus_name_underlabel.SetData(static_cast<string>(name)).SetPosition(project(stop->GetCoordinates()))
                             .SetOffset(settings_.bus_label_offset).SetFontSize(settings_.bus_label_font_size)
                             .SetFontFamily("Verdana"s).SetFontWeight("bold"s).SetStrokeWidth(settings_.underlayer_width)
                             .SetFillColor(settings_.underlayer_color).SetStrokeColor(settings_.underlayer_color)
                             .SetStrokeLineCap(StrokeLineCap::ROUND).SetStrokeLineJoin(StrokeLineJoin::ROUND);
 
-    bus_name_label.SetData(static_cast<string>(name)).SetPosition(project(stop->coordinates))
+    bus_name_label.SetData(static_cast<string>(name)).SetPosition(project(stop->GetCoordinates()))
                     .SetOffset(settings_.bus_label_offset).SetFontSize(settings_.bus_label_font_size)
                     .SetFontFamily("Verdana"s).SetFontWeight("bold"s).SetFillColor(settings_.color_palette[index_color]);
 
@@ -86,15 +110,18 @@ set<string_view> MapRenderer::RenderBuses(SphereProjector& project, Document& do
 
         unique_ptr<Text> bus_label_start, bus_underlabel_start,
                          bus_label_finish, bus_underlabel_finish;
-        tie(bus_underlabel_start, bus_label_start) =  AddBusLabels(project, index_color, bus->stops.front(), bus_name);
-        if (!bus->is_ring && (bus->stops.front() != bus->stops[bus->stops.size()/2])) {
+        const Stop* first_stop = &catalog_.GetStop(bus->stops.front());
+        const Stop* last_stop = &catalog_.GetStop(bus->stops.back());
+        tie(bus_underlabel_start, bus_label_start) =  AddBusLabels(project, index_color, first_stop, bus_name);
+        if (!bus->is_ring && (first_stop != last_stop)) {
             tie(bus_underlabel_finish, bus_label_finish) = AddBusLabels(project,
-                                                                index_color, bus->stops[bus->stops.size()/2], bus_name);
+                                                                index_color, last_stop, bus_name);
         }
 
-        for (const Stop* stop : bus->stops) {
-            line->AddPoint(project(stop->coordinates));
-            stops_in_buses.insert(stop->name);
+        for (StopId stop_id : bus->GetRoute()) {
+            const Stop& stop = catalog_.GetStop(stop_id);
+            line->AddPoint(project(stop.GetCoordinates()));
+            stops_in_buses.insert(stop.name);
         }
 
         bus_lines.push_back(move(line));
@@ -124,7 +151,7 @@ void MapRenderer::RenderStops(SphereProjector& project, svg::Document& doc_to_re
 
     for (string_view stop_name : stops_in_buses) {
         const Stop* stop = *(catalog_.GetStopInfo(stop_name));
-        Point coords = project(stop->coordinates);
+        Point coords = project(stop->GetCoordinates());
 
         unique_ptr<Circle> stop_point = make_unique<Circle>(Circle().SetCenter(coords)
                                                                     .SetRadius(settings_.stop_radius)
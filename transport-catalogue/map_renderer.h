@@ -4,11 +4,16 @@
 #include "transport_catalogue.h"
 #include "geo.h"
 
+#include <cmath>
+#include <optional>
 #include <ostream>
+#include <string>
 
 namespace tr_cat {
 namespace render {
 
+inline const double EPSILON = 1e-6;
+
 inline bool IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
@@ -99,12 +104,8 @@ struct RenderSettings {
     double underlayer_width = 0;
     std::vector<svg::Color> color_palette;
 
-};
+    int precision = numbers::DEFAULT_PRECISION; //значащих цифр в SVG, numbers::SHORTEST - кратчайшая запись
 
-struct CoordinatesHasher {
-    size_t operator() (const geo::Coordinates& coords) const {
-        return std::hash<double>{}(coords.lat) + std::hash<double>{}(coords.lng)*37;
-    }
 };
 
 class MapRenderer {
@@ -115,16 +116,22 @@ public:
 
     //bool Deserialize (transport_catalog_serialize::RenderSettings& settings);
 
-    void SetRenderSettings(RenderSettings&& settings) {settings_ = settings;}
+    void SetRenderSettings(RenderSettings&& settings) {settings_ = settings; rendered_map_.reset();}
     void Render(std::ostream& out);
 
+    //SVG карты: берётся из базы или рисуется при первом обращении
+    const std::string& GetRenderedMap();
+    void SetRenderedMap(std::string svg) {rendered_map_ = std::move(svg);}
+
     RenderSettings GetSettings();
     RenderSettings& GetSettingsRef();
 
 private:
     const aggregations::TransportCatalogue& catalog_;
     RenderSettings settings_;
-    std::unordered_set<geo::Coordinates, CoordinatesHasher> CollectCoordinates () const;
+    std::optional<std::string> rendered_map_;
+    void Draw(std::ostream& out);
+    std::vector<geo::Coordinates> CollectCoordinates () const;
     std::pair<std::unique_ptr<svg::Text>, std::unique_ptr<svg::Text>> AddBusLabels(SphereProjector& project,
                                                     int index_color, const Stop* stop, std::string_view name);
     std::set<std::string_view> RenderBuses(SphereProjector& project, svg::Document& doc_to_render);
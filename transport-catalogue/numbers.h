@@ -0,0 +1,45 @@
+#pragma once
+
+#include <charconv>
+#include <iostream>
+#include <string_view>
+
+namespace numbers {
+
+//Вывод double без потоков и локали, через std::to_chars. Точность - число значащих цифр,
+//как у потока с setprecision (формат %g); SHORTEST - кратчайшая запись, которая читается
+//обратно в то же число
+
+inline constexpr int SHORTEST = 0;
+//точность потока по умолчанию, с ней вывод совпадает с operator<< без настроек
+inline constexpr int DEFAULT_PRECISION = 6;
+//больше значащих цифр double не различает
+inline constexpr int MAX_PRECISION = 17;
+//хватает на любое число с точностью до MAX_PRECISION
+inline constexpr size_t MAX_SIZE = 32;
+
+inline bool IsValidPrecision(int precision) {
+    return precision >= SHORTEST && precision <= MAX_PRECISION;
+}
+
+//пишет value в [first, first + MAX_SIZE) и возвращает конец записи
+inline char* Format(char* first, double value, int precision = DEFAULT_PRECISION) {
+    const std::to_chars_result result = precision == SHORTEST
+        ? std::to_chars(first, first + MAX_SIZE, value)
+        : std::to_chars(first, first + MAX_SIZE, value, std::chars_format::general, precision);
+    return result.ptr;
+}
+
+//число для вывода в поток: out << numbers::Double{value, precision}
+struct Double {
+    double value;
+    int precision = DEFAULT_PRECISION;
+};
+
+inline std::ostream& operator<< (std::ostream& out, Double number) {
+    char text[MAX_SIZE];
+    const char* end = Format(text, number.value, number.precision);
+    return out.write(text, end - text);
+}
+
+}//numbers
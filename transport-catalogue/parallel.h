@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace tr_cat {
+namespace parallel {
+
+//число потоков для задачи из count элементов, если на поток нужно не меньше min_part элементов
+inline size_t GetPartsCount(size_t count, size_t min_part) {
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(hardware, count / std::max<size_t>(1, min_part)));
+}
+
+//делит [0, count) на непрерывные части и вызывает func(first, last) для каждой в своём потоке,
+//первая часть выполняется в вызывающем потоке; исключение из любой части пробрасывается
+//после завершения всех частей
+template <typename Func>
+void ForEachRange(size_t count, size_t min_part, Func func) {
+    const size_t parts = GetPartsCount(count, min_part);
+    if (parts == 1) {
+        func(size_t{0}, count);
+        return;
+    }
+    std::vector<std::future<void>> futures;
+    futures.reserve(parts - 1);
+    for (size_t part = 1; part < parts; ++part) {
+        futures.push_back(std::async(std::launch::async, func, part * count / parts, (part + 1) * count / parts));
+    }
+    func(size_t{0}, count / parts);
+    for (std::future<void>& future : futures) {
+        future.get();
+    }
+}
+
+}//parallel
+}//tr_cat
@@ -0,0 +1,186 @@
+#include "proto_reader.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <google/protobuf/util/delimited_message_util.h>
+
+namespace tr_cat {
+    namespace interface {
+        using namespace std;
+        namespace proto = transport_catalog_serialize;
+
+        namespace {
+            //больше запрос или ответ не бывает; длина сверх этого - признак битого потока
+            constexpr uint32_t MAX_MESSAGE_SIZE = 64u << 20;
+
+            //длина сообщения и само сообщение читаются из потока ровно по байтам, без упреждающего
+            //чтения блоками: иначе ответ на запрос ждал бы, пока клиент пришлёт следующие.
+            //false, если поток закончился ровно перед сообщением
+            bool ReadMessage(google::protobuf::MessageLite& message, istream& input, string& buffer) {
+                uint32_t size = 0;
+                for (int shift = 0;; shift += 7) {
+                    const int byte = input.get();
+                    if (byte == istream::traits_type::eof() && shift == 0) {
+                        return false;
+                    }
+                    //длина - uint32: в пятом байте значимы только младшие 4 бита
+                    if (byte == istream::traits_type::eof() || (shift == 28 && byte > 0x0f)) {
+                        throw runtime_error("Broken request stream"s);
+                    }
+                    size |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0) {
+                        break;
+                    }
+                }
+                if (size > MAX_MESSAGE_SIZE) {
+                    throw runtime_error("Broken request stream"s);
+                }
+                buffer.resize(size);
+                input.read(buffer.data(), static_cast<streamsize>(size));
+                if (static_cast<size_t>(input.gcount()) != size || !message.ParseFromString(buffer)) {
+                    throw runtime_error("Broken request stream"s);
+                }
+                return true;
+            }
+
+            //тип запроса в виде, в котором его сравнивает GetAnswer; пустой для неизвестного:
+            //enum в proto3 открыт, и клиент новее сервера может прислать тип, которого здесь нет
+            string_view TypeName(proto::StatRequest::Type type) {
+                switch (type) {
+                    case proto::StatRequest::TYPE_UNSPECIFIED: return {};
+                    case proto::StatRequest::BUS: return "Bus"sv;
+                    case proto::StatRequest::STOP: return "Stop"sv;
+                    case proto::StatRequest::MAP: return "Map"sv;
+                    case proto::StatRequest::ROUTE: return "Route"sv;
+                    default: return {};
+                }
+            }
+        }//namespace
+
+        void ProtoReader::ReadDocument() {
+            proto::RequestSettings settings;
+            if (ReadMessage(settings, input_, message_buffer_)) {
+                settings_ = move(settings);
+            }
+        }
+
+        void ProtoReader::ParseDocument() {
+            if (!settings_) {
+                return;
+            }
+            serializator_.SetPathToSerialize(settings_->file());
+            if (!settings_->route_cache().empty()) {
+                serializator_.SetRouteCache(settings_->route_cache(),
+                                            settings_->has_route_cache_size() ? settings_->route_cache_size()
+                                                                              : DEFAULT_ROUTE_CACHE_SIZE);
+            }
+        }
+
+        void ProtoReader::ProcessRequests() {
+            proto::StatRequest request;
+            while (ReadMessage(request, input_, message_buffer_)) {
+                const Stat stat{request.id(), TypeName(request.type()), request.name(), request.from(), request.to()};
+                try {
+                    if (stat.type.empty()) {
+                        throw invalid_argument("Unknown type"s);
+                    }
+                    Answer answer = GetAnswer(stat);
+                    WriteAnswer(answer);
+                } catch (const exception& error) {
+                    proto::StatAnswer message;
+                    message.set_request_id(request.id());
+                    message.set_error_message(error.what());
+                    WriteMessage(message);
+                }
+                output_.flush();
+            }
+        }
+
+        void ProtoReader::PrintAnswers() {
+            for (auto& answer : answers_) {
+                WriteAnswer(answer);
+            }
+            output_.flush();
+        }
+
+        void ProtoReader::WriteAnswer(Answer& answer) {
+            proto::StatAnswer message;
+            visit(AnswerBuilder{GetCatalog(), renderer_, serializator_, message}, answer);
+            WriteMessage(message);
+        }
+
+        void ProtoReader::WriteMessage(const proto::StatAnswer& message) {
+            if (!google::protobuf::util::SerializeDelimitedToOstream(message, &output_)) {
+                throw runtime_error("Can't write answer"s);
+            }
+        }
+
+        bool ProtoReader::TestingFilesOutput(std::string filename_lhs, std::string filename_rhs) {
+            ifstream lhs_file(filename_lhs, ios::binary);
+            ifstream rhs_file(filename_rhs, ios::binary);
+            proto::StatAnswer lhs, rhs;
+            string buffer;
+            for (size_t i = 0;; ++i) {
+                const bool has_lhs = ReadMessage(lhs, lhs_file, buffer);
+                const bool has_rhs = ReadMessage(rhs, rhs_file, buffer);
+                if (!has_lhs || !has_rhs) {
+                    return has_lhs == has_rhs;
+                }
+                if (lhs.SerializeAsString() != rhs.SerializeAsString()) {
+                    cerr << "Answers not equal. Index: "s << i << endl;
+                    return false;
+                }
+            }
+        }
+
+//-----------------------------AnswerBuilder-----------------------------------
+
+        void ProtoReader::AnswerBuilder::operator() (int value) {
+            answer_.set_request_id(value);
+            answer_.set_error_message("not found"s);
+        }
+
+        void ProtoReader::AnswerBuilder::operator() (StopOutput& value) {
+            answer_.set_request_id(value.id);
+            proto::StopAnswer& stop = *answer_.mutable_stop();
+            for (BusId bus : catalog_.GetStopBuses(value.stop->id)) {
+                stop.add_buses(catalog_.GetBus(bus).name);
+            }
+        }
+
+        void ProtoReader::AnswerBuilder::operator() (BusOutput& value) {
+            answer_.set_request_id(value.id);
+            proto::BusAnswer& bus = *answer_.mutable_bus();
+            bus.set_curvature(value.bus->curvature);
+            bus.set_route_length(value.bus->distance);
+            bus.set_stop_count(static_cast<uint32_t>(value.bus->GetStopCount()));
+            bus.set_unique_stop_count(value.bus->unique_stops);
+        }
+
+        void ProtoReader::AnswerBuilder::operator() (MapOutput& value) {
+            serializator_.LoadRenderer();
+            answer_.set_request_id(value.id);
+            answer_.set_map(renderer_.GetRenderedMap());
+        }
+
+        void ProtoReader::AnswerBuilder::operator() (RouteOutput& value) {
+            const std::optional<router::CompletedRoute>& result = serializator_.FindRoute(value.from->id, value.to->id);
+            if (!result) {
+                (*this)(value.id);
+                return;
+            }
+            answer_.set_request_id(value.id);
+            proto::RouteAnswer& route = *answer_.mutable_route();
+            route.set_total_time(result->total_time);
+            for (const router::CompletedRoute::Line& line : result->route) {
+                proto::RouteItem& item = *route.add_items();
+                item.set_stop_name(line.stop->name);
+                item.set_wait_time(line.wait_time);
+                item.set_bus(line.bus->name);
+                item.set_span_count(static_cast<uint32_t>(line.count_stops));
+                item.set_time(line.run_time);
+            }
+        }
+
+    }//interface
+}//tr_cat
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "request_handler.h"
+#include "map_renderer.h"
+#include "transport_router.h"
+#include "serialization.h"
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <requests.pb.h>
+
+namespace tr_cat {
+namespace interface {
+
+//запросы и ответы в двоичном протоколе из requests.proto вместо JSON. Заполнять базу
+//он не умеет: сообщения несут только stat-запросы, поэтому работает только с process_requests.
+//ReadDocument читает только RequestSettings, запросы читает ProcessRequests по одному
+class ProtoReader : public RequestInterface {
+public:
+    explicit ProtoReader(aggregations::TransportCatalogue& catalog)
+    :RequestInterface (catalog)
+    , transport_router_(catalog)
+    , renderer_(catalog)
+    , serializator_(catalog, renderer_, transport_router_){}
+
+    ProtoReader(aggregations::TransportCatalogue& catalog, std::istream& input, std::ostream& output)
+    :RequestInterface (catalog, input, output)
+    , transport_router_(catalog)
+    , renderer_(catalog)
+    , serializator_(catalog, renderer_, transport_router_){}
+
+    void ReadDocument () override;
+    void ParseDocument () override;
+    bool Serialize(bool with_graph = false) const override {return serializator_.Serialize(with_graph);}
+    bool Deserialize(bool with_graph = false) override {
+        const bool result = serializator_.Deserialize(with_graph);
+        serializator_.LoadRouteCache();
+        return result;
+    }
+    bool SaveRouteCache() override {return serializator_.SaveRouteCache();}
+    void RenderMap(std::ostream& out = std::cout) override {
+        serializator_.LoadRenderer();
+        renderer_.Render(out);
+    }
+    void CreateGraph() override {transport_router_.CreateGraph();}
+    //отвечает на каждый StatRequest, как только он прочитан, и сразу сбрасывает ответ в поток;
+    //ошибка в запросе (например, неизвестный тип) - ответ с error_message, а не конец работы
+    void ProcessRequests ();
+    void PrintAnswers () override;
+    //сравнивает потоки ответов StatAnswer из двух файлов
+    bool TestingFilesOutput(std::string filename_lhs, std::string filename_rhs) override;
+
+private:
+    //заполняет StatAnswer
+    struct AnswerBuilder {
+        void operator() (int value);
+        void operator() (StopOutput& value);
+        void operator() (BusOutput& value);
+        void operator() (MapOutput& value);
+        void operator() (RouteOutput& value);
+
+        const aggregations::TransportCatalogue& catalog_;
+        render::MapRenderer& renderer_;
+        serialize::Serializator& serializator_;
+        transport_catalog_serialize::StatAnswer& answer_;
+    };
+
+    std::optional<transport_catalog_serialize::RequestSettings> settings_;
+    std::string message_buffer_;
+    router::TransportRouter transport_router_;
+    render::MapRenderer renderer_;
+    serialize::Serializator serializator_;
+
+    void WriteAnswer(Answer& answer);
+    void WriteMessage(const transport_catalog_serialize::StatAnswer& message);
+};
+
+}//interface
+}//tr_cat
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -24,6 +25,9 @@ public:
     It end() const {
         return end_;
     }
+    size_t size() const {
+        return static_cast<size_t>(std::distance(begin_, end_));
+    }
 
 private:
     It begin_;
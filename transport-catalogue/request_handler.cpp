@@ -4,61 +4,92 @@ namespace tr_cat {
     namespace interface {
         using namespace std;
 
-        void RequestInterface::AddStops () {
-            std::for_each(stops_.begin(), stops_.end(), [&](StopInput& stop) {catalog_.AddStop(stop.name, stop.coordinates);});
-        }
-
         void RequestInterface::AddDistances () {
-            for (auto& [lhs, stops] : distances_) {
-                for (auto& [rhs, value] : stops) {
-                    catalog_.AddDistance(lhs, rhs, value);
+            for (const DistanceInput& distance : distances_) {
+                optional<const Stop*> to = catalog_.GetStopInfo(distance.to);
+                if (!to) {
+                    throw invalid_argument("Unknown stop "s + string(distance.to));
                 }
+                catalog_.AddDistance(distance.from, (*to)->id, distance.distance);
             }
+            distances_ = {};
         }
 
         void RequestInterface::AddBuses () {
             std::for_each(buses_.begin(), buses_.end(), [&](BusInput& bus) {catalog_.AddBus(bus.name, bus.stops, bus.is_ring);});
+            buses_ = {};
+            interned_names_ = {};
+            names_ = {};
+            catalog_.Freeze();
         }
 
-        void RequestInterface::GetAnswers() {
+        StopId RequestInterface::ReadStop(string_view name, geo::Coordinates coordinates) {
+            catalog_.AddStop(name, coordinates);
+            return catalog_.GetStops().back().id;
+        }
+
+        void RequestInterface::ReadDistance(StopId from, string_view to, int distance) {
+            distances_.push_back({from, InternName(to), distance});
+        }
 
+        void RequestInterface::ReadBus(string_view name, const vector<string_view>& stops, bool is_ring) {
+            BusInput& bus = buses_.emplace_back();
+            bus.name = name;
+            bus.is_ring = is_ring;
+            bus.stops.reserve(stops.size());
+            for (string_view stop : stops) {
+                bus.stops.push_back(InternName(stop));
+            }
+        }
+
+        string_view RequestInterface::InternName(string_view name) {
+            if (optional<const Stop*> stop = catalog_.GetStopInfo(name)) {
+                return (*stop)->name;
+            }
+            if (auto it = interned_names_.find(name); it != interned_names_.end()) {
+                return *it;
+            }
+            return *interned_names_.insert(names_.emplace_back(name)).first;
+        }
+
+        void RequestInterface::GetAnswers() {
+            answers_.reserve(answers_.size() + stats_.size());
             for (const Stat& stat : stats_) {
-                if (stat.type == "Bus"s) {
-                    optional<const Bus*> bus = catalog_.GetBusInfo(stat.name);
-                    if (!bus) {
-                        answers_.push_back(stat.id); //если не найдено, передаём id запроса
-                        continue;
-                    }
-                    answers_.push_back(BusOutput{stat.id, *bus});
+                answers_.push_back(GetAnswer(stat));
+            }
+        }
+
+        RequestInterface::Answer RequestInterface::GetAnswer(const Stat& stat) {
+            if (stat.type == "Bus"s) {
+                optional<const Bus*> bus = catalog_.GetBusInfo(stat.name);
+                if (!bus) {
+                    return stat.id; //если не найдено, передаём id запроса
+                }
+                return BusOutput{stat.id, *bus};
 
-                } else if (stat.type == "Stop"s) {
-                    optional<const Stop*> stop = catalog_.GetStopInfo(stat.name);
-                    if (!stop) {
-                        answers_.push_back(stat.id); //если не найдено, передаём id запроса
-                        continue;
-                    }
-                    answers_.push_back(StopOutput{stat.id, *stop});
+            } else if (stat.type == "Stop"s) {
+                optional<const Stop*> stop = catalog_.GetStopInfo(stat.name);
+                if (!stop) {
+                    return stat.id; //если не найдено, передаём id запроса
+                }
+                return StopOutput{stat.id, *stop};
 
-                } else if (stat.type == "Map"s) {
-                    answers_.push_back(MapOutput(stat.id, catalog_));
+            } else if (stat.type == "Map"s) {
+                return MapOutput(stat.id, catalog_);
 
-                } else if (stat.type == "Route"s) {
-                    optional<const Stop*> from = catalog_.GetStopInfo(stat.from);
-                    optional<const Stop*> to = catalog_.GetStopInfo(stat.to);
-                    if (!from || !to) {
-                        answers_.push_back(stat.id); //если не найдено, передаём id запроса
-                        continue;
-                    }
-                    answers_.push_back(RouteOutput({stat.id, *from, *to}));
-                } else {
-                    throw invalid_argument ("Invalid Stat"s);
+            } else if (stat.type == "Route"s) {
+                optional<const Stop*> from = catalog_.GetStopInfo(stat.from);
+                optional<const Stop*> to = catalog_.GetStopInfo(stat.to);
+                if (!from || !to) {
+                    return stat.id; //если не найдено, передаём id запроса
                 }
+                return RouteOutput({stat.id, *from, *to});
             }
+            throw invalid_argument ("Invalid Stat"s);
         }
         void Process(interface::RequestInterface& reader) {
             reader.ReadDocument();
             reader.ParseDocument();
-            reader.AddStops();
             reader.AddDistances();
             reader.AddBuses();
             reader.CreateGraph();
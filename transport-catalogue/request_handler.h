@@ -2,7 +2,10 @@
 
 #include "transport_catalogue.h"
 
+#include <deque>
 #include <iostream>
+#include <string>
+#include <unordered_set>
 #include <optional>
 #include <variant>
 #include <sstream>
@@ -11,6 +14,10 @@ namespace tr_cat {
 namespace interface {
 
 using namespace std::string_literals;
+
+//сколько самых запрашиваемых маршрутов сохраняется в кэш, если route_cache_size не задан
+inline constexpr int DEFAULT_ROUTE_CACHE_SIZE = 1 << 16;
+
 class RequestInterface {
 public:
     explicit RequestInterface(aggregations::TransportCatalogue& catalog)
@@ -26,7 +33,8 @@ public:
     virtual void ReadDocument () = 0;
     virtual void ParseDocument () = 0;
 //--------------------------------------------base filling-----------------------------------------------------
-    void AddStops ();
+    //остановки попадают в каталог сразу при чтении (ReadStop), расстояния и автобусы
+    //добавляются после чтения всех остановок, потому что могут ссылаться на ещё не прочитанные
     void AddDistances ();
     void AddBuses ();
     virtual void CreateGraph() = 0;
@@ -37,6 +45,8 @@ public:
 //--------------------------------------------serializstion-----------------------------------------------------
     virtual bool Serialize (bool with_graph) const = 0;
     virtual bool Deserialize (bool with_graph) = 0;
+    //сохраняет кэш маршрутов для следующего запуска, если он включён
+    virtual bool SaveRouteCache () = 0;
 //------------------------------------------------------------------------------------------------------
 
     virtual bool TestingFilesOutput(std::string filename_lhs,
@@ -47,13 +57,14 @@ public:
 protected:
     const aggregations::TransportCatalogue& GetCatalog() const {return catalog_;}
     struct BusInput {
-        std::string_view name;
-        std::vector <std::string_view> stops;
+        std::string name;
+        std::vector <std::string_view> stops; //названия из InternName
         bool is_ring;
     };
-    struct StopInput {
-        std::string_view name;
-        geo::Coordinates coordinates;
+    struct DistanceInput {
+        StopId from;
+        std::string_view to; //название из InternName
+        int distance;
     };
     struct Stat {
         int id;
@@ -81,16 +92,29 @@ protected:
         const Stop* from;
         const Stop* to;
     };
-    std::vector<StopInput> stops_;
     std::vector<BusInput> buses_;
-    std::unordered_map<std::string_view, std::vector<std::pair<std::string_view, int>>> distances_;
+    std::vector<DistanceInput> distances_;
     std::vector<Stat> stats_;
-    std::vector<std::variant<int, StopOutput, BusOutput, MapOutput, RouteOutput>> answers_;
+    //int - id запроса, на который нет ответа
+    using Answer = std::variant<int, StopOutput, BusOutput, MapOutput, RouteOutput>;
+    std::vector<Answer> answers_;
     std::istream& input_ = std::cin;
     std::ostream& output_ = std::cout;
 
+    //заполнение базы по мере чтения запросов
+    StopId ReadStop(std::string_view name, geo::Coordinates coordinates);
+    void ReadDistance(StopId from, std::string_view to, int distance);
+    void ReadBus(std::string_view name, const std::vector<std::string_view>& stops, bool is_ring);
+
+    //названия остановок, на которые ссылаются расстояния и автобусы: для уже добавленных
+    //это названия из каталога, для остальных - копии в names_
+    std::string_view InternName(std::string_view name);
+    Answer GetAnswer(const Stat& stat);
+
 private:
     aggregations::TransportCatalogue& catalog_;
+    std::deque<std::string> names_;
+    std::unordered_set<std::string_view> interned_names_;
 };
 
 void Process(interface::RequestInterface& reader);
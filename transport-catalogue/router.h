@@ -8,6 +8,7 @@
 #include <iterator>
 #include <optional>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -19,156 +20,227 @@ template <typename Weight>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
 public:
-    explicit Router(const Graph& graph);
-    Router(const Graph& graph, const transport_catalog_serialize::RoutesData& routes_data);
+    //значения prev_edge в таблице маршрутов, кроме номеров рёбер
+    static constexpr int32_t NO_EDGE = -1;  //маршрут из вершины в саму себя
+    static constexpr int32_t NO_ROUTE = -2; //маршрута нет
+
+    //при compute_routes = false таблица пуста (маршрутов нет) и заполняется построчно SetDeserializeRow
+    explicit Router(const Graph& graph, bool compute_routes = true);
+    //таблица маршрутов во внешней памяти, например в отображённом в память файле базы:
+    //weights и prev_edges - матрицы vertex_count x vertex_count, записанные по строкам
+    Router(const Graph& graph, const Weight* weights, const int32_t* prev_edges);
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
 
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    transport_catalog_serialize::RoutesData GetSerializeData() const;
+    //строки таблицы пишутся и читаются по одной, чтобы не держать в памяти копию всей таблицы
+    void GetSerializeRow(VertexId from, transport_catalog_serialize::RoutesRow& row) const;
+    void SetDeserializeRow(VertexId from, const transport_catalog_serialize::RoutesRow& row);
+    //строка from целиком, vertex_count значений в каждом массиве
+    void SetRow(VertexId from, const Weight* weights, const int32_t* prev_edges);
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    size_t GetVertexCount() const {return vertex_count_;}
+    const Weight* GetWeights() const {return weights_;}
+    const int32_t* GetPrevEdges() const {return prev_edges_;}
+
 private:
 
+    size_t Index(VertexId from, VertexId to) const {
+        return from * vertex_count_ + to;
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            weights_storage_[Index(vertex, vertex)] = ZERO_WEIGHT;
+            prev_edges_storage_[Index(vertex, vertex)] = NO_EDGE;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t index = Index(vertex, edge.to);
+                if (prev_edges_storage_[index] == NO_ROUTE || weights_storage_[index] > edge.weight) {
+                    weights_storage_[index] = edge.weight;
+                    prev_edges_storage_[index] = static_cast<int32_t>(edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
-        }
-    }
-
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+    void RelaxRoutesInternalDataThroughVertex(VertexId vertex_through) {
+        const Weight* weights_through = &weights_storage_[Index(vertex_through, 0)];
+        const int32_t* prev_edges_through = &prev_edges_storage_[Index(vertex_through, 0)];
+        for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+            const int32_t prev_edge_from = prev_edges_storage_[Index(vertex_from, vertex_through)];
+            if (prev_edge_from == NO_ROUTE) {
+                continue;
+            }
+            const Weight weight_from = weights_storage_[Index(vertex_from, vertex_through)];
+            Weight* weights_relaxing = &weights_storage_[Index(vertex_from, 0)];
+            int32_t* prev_edges_relaxing = &prev_edges_storage_[Index(vertex_from, 0)];
+            for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+                if (prev_edges_through[vertex_to] == NO_ROUTE) {
+                    continue;
+                }
+                const Weight candidate_weight = weight_from + weights_through[vertex_to];
+                if (prev_edges_relaxing[vertex_to] == NO_ROUTE || candidate_weight < weights_relaxing[vertex_to]) {
+                    weights_relaxing[vertex_to] = candidate_weight;
+                    prev_edges_relaxing[vertex_to] = prev_edges_through[vertex_to] != NO_EDGE
+                                                   ? prev_edges_through[vertex_to] : prev_edge_from;
                 }
             }
         }
     }
 
-    RoutesInternalData SetDeserializeData(const transport_catalog_serialize::RoutesData& data) const{
-        RoutesInternalData routes_internal_data;
-        routes_internal_data.reserve(data.data_size());
-        for (int i = 0; i < data.data_size(); ++i) {
-            const transport_catalog_serialize::ArrayRouteInternalData& array_in = data.data(i);
-            std::vector<std::optional<RouteInternalData>> array_to_write;
-            array_to_write.reserve(array_in.data_size());
-            for (int j = 0; j < array_in.data_size(); ++j) {
-                if (array_in.data(j).has_value()){
-                    const transport_catalog_serialize::RouteInternalData& route_in = array_in.data(j);
-                    std::optional<EdgeId> prev_edge;
-                    if (route_in.prev_edge() == -1) {
-                        prev_edge = std::nullopt;
-                    } else {
-                        prev_edge = static_cast<EdgeId>(route_in.prev_edge());
-                    }
-                    array_to_write.push_back(RouteInternalData{route_in.weight(), prev_edge});
-                } else {
-                    array_to_write.push_back(std::nullopt);
-                }
-            }
-            routes_internal_data.push_back(move(array_to_write));
-        }
-        return routes_internal_data;
+    static bool IsUnreachable(const std::string& bitmap, VertexId vertex) {
+        return (static_cast<unsigned char>(bitmap[vertex / 8]) >> (vertex % 8)) & 1u;
+    }
+
+    void UseStorage() {
+        weights_ = weights_storage_.data();
+        prev_edges_ = prev_edges_storage_.data();
     }
 
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    size_t vertex_count_;
+    std::vector<Weight> weights_storage_;
+    std::vector<int32_t> prev_edges_storage_;
+    //таблица, с которой работает BuildRoute: собственные векторы или внешняя память
+    const Weight* weights_ = nullptr;
+    const int32_t* prev_edges_ = nullptr;
 };
+
 template <typename Weight>
-transport_catalog_serialize::RoutesData Router<Weight>::GetSerializeData() const {
-    transport_catalog_serialize::RoutesData data_out;
-    for (const std::vector<std::optional<RouteInternalData>>& array_route_internal_data : routes_internal_data_) {
-        transport_catalog_serialize::ArrayRouteInternalData array_out;
-        for (const std::optional<RouteInternalData>& route : array_route_internal_data) {
-            transport_catalog_serialize::RouteInternalData route_out;
-            if (route) {
-                route_out.set_weight(route->weight);
-                if (route->prev_edge) {
-                    route_out.set_prev_edge(*route->prev_edge);
-                } else {
-                    route_out.set_prev_edge(-1);
-                }
-                route_out.set_has_value(true);
-            } else {
-                route_out.set_has_value(false);
-            }
-            array_out.add_data();
-            *array_out.mutable_data(array_out.data_size()-1) = std::move(route_out);
+void Router<Weight>::GetSerializeRow(VertexId from, transport_catalog_serialize::RoutesRow& row) const {
+    if (from >= vertex_count_) {
+        throw std::out_of_range("Router: vertex out of range");
+    }
+    const Weight* weights = weights_ + Index(from, 0);
+    const int32_t* prev_edges = prev_edges_ + Index(from, 0);
+    const size_t reachable_count = vertex_count_ - std::count(prev_edges, prev_edges + vertex_count_, NO_ROUTE);
+    if (reachable_count == vertex_count_) {
+        row.mutable_weight()->Add(weights, weights + vertex_count_);
+        row.mutable_prev_edge()->Add(prev_edges, prev_edges + vertex_count_);
+        return;
+    }
+    std::string unreachable((vertex_count_ + 7) / 8, '\0');
+    row.mutable_weight()->Reserve(static_cast<int>(reachable_count));
+    row.mutable_prev_edge()->Reserve(static_cast<int>(reachable_count));
+    for (VertexId to = 0; to < vertex_count_; ++to) {
+        if (prev_edges[to] == NO_ROUTE) {
+            unreachable[to / 8] = static_cast<char>(unreachable[to / 8] | (1u << (to % 8)));
+        } else {
+            row.add_weight(weights[to]);
+            row.add_prev_edge(prev_edges[to]);
         }
-        data_out.add_data();
-        *data_out.mutable_data(data_out.data_size()-1) = std::move(array_out);
     }
-    return data_out;
+    row.set_unreachable(std::move(unreachable));
 }
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+void Router<Weight>::SetDeserializeRow(VertexId from, const transport_catalog_serialize::RoutesRow& row) {
+    if (from >= vertex_count_ || weights_storage_.empty()) {
+        throw std::invalid_argument("Routes data: wrong row");
+    }
+    Weight* weights = &weights_storage_[Index(from, 0)];
+    int32_t* prev_edges = &prev_edges_storage_[Index(from, 0)];
+    const std::string& unreachable = row.unreachable();
+    size_t reachable_count = vertex_count_;
+    if (!unreachable.empty()) {
+        if (unreachable.size() != (vertex_count_ + 7) / 8) {
+            throw std::invalid_argument("Routes data: wrong unreachable bitmap");
+        }
+        reachable_count = 0;
+        for (VertexId to = 0; to < vertex_count_; ++to) {
+            reachable_count += IsUnreachable(unreachable, to) ? 0 : 1;
+        }
+    }
+    if (static_cast<size_t>(row.weight_size()) != reachable_count
+        || static_cast<size_t>(row.prev_edge_size()) != reachable_count) {
+        throw std::invalid_argument("Routes data: wrong row size");
+    }
+    if (unreachable.empty()) {
+        std::copy(row.weight().begin(), row.weight().end(), weights);
+        std::copy(row.prev_edge().begin(), row.prev_edge().end(), prev_edges);
+        return;
+    }
+    for (VertexId to = 0, cell = 0; to < vertex_count_; ++to) {
+        if (IsUnreachable(unreachable, to)) {
+            weights[to] = ZERO_WEIGHT;
+            prev_edges[to] = NO_ROUTE;
+        } else {
+            weights[to] = row.weight(cell);
+            prev_edges[to] = row.prev_edge(cell);
+            ++cell;
+        }
+    }
+}
+
+template <typename Weight>
+void Router<Weight>::SetRow(VertexId from, const Weight* weights, const int32_t* prev_edges) {
+    if (from >= vertex_count_ || weights_storage_.empty()) {
+        throw std::invalid_argument("Routes data: wrong row");
+    }
+    std::copy(weights, weights + vertex_count_, &weights_storage_[Index(from, 0)]);
+    std::copy(prev_edges, prev_edges + vertex_count_, &prev_edges_storage_[Index(from, 0)]);
+}
+
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, bool compute_routes)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , vertex_count_(graph.GetVertexCount())
+    , weights_storage_(vertex_count_ * vertex_count_, ZERO_WEIGHT)
+    , prev_edges_storage_(vertex_count_ * vertex_count_, NO_ROUTE)
 {
+    UseStorage();
+    if (!compute_routes) {
+        return;
+    }
     InitializeRoutesInternalData(graph);
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    for (VertexId vertex_through = 0; vertex_through < vertex_count_; ++vertex_through) {
+        RelaxRoutesInternalDataThroughVertex(vertex_through);
     }
 }
+
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph, const transport_catalog_serialize::RoutesData& routes_data)
-    :graph_(graph)
-    ,routes_internal_data_(SetDeserializeData(routes_data)){}
+Router<Weight>::Router(const Graph& graph, const Weight* weights, const int32_t* prev_edges)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , weights_(weights)
+    , prev_edges_(prev_edges) {}
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Router: vertex out of range");
+    }
+    const int32_t prev_edge = prev_edges_[Index(from, to)];
+    if (prev_edge == NO_ROUTE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    const Weight weight = weights_[Index(from, to)];
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (int32_t edge_id = prev_edge;
+         edge_id != NO_EDGE;
+         edge_id = prev_edges_[Index(from, graph_.GetEdge(edge_id).from)])
     {
-        edges.push_back(*edge_id);
+        //таблица может быть отображена из файла базы: отрицательный номер ребра или
+        //зацикленная цепочка означают, что она повреждена
+        if (edge_id < 0 || edges.size() >= vertex_count_) {
+            throw std::runtime_error("Router: broken routes table");
+        }
+        edges.push_back(static_cast<EdgeId>(edge_id));
     }
     std::reverse(edges.begin(), edges.end());
 
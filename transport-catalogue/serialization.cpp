@@ -1,115 +1,607 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
 #include <optional>
+#include <stdexcept>
 #include "serialization.h"
+#include "parallel.h"
+#include "delta_base.h"
+
+#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 
 using namespace router;
 
 namespace tr_cat {
 namespace serialize {
 
+namespace {
+
+//крупные секции пишутся частями не больше SECTION_CHUNK_SIZE записей,
+//чтобы не собирать в памяти копию всего каталога или графа
+constexpr size_t SECTION_CHUNK_SIZE = 1 << 16;
+
+//строки таблицы маршрутов читаются из файла блоками примерно такого размера
+constexpr uint64_t ROWS_BLOCK_SIZE = 1 << 24;
+//меньше строк на поток не делим: разбор короткой строки дешевле запуска потока
+constexpr size_t MIN_ROWS_PER_THREAD = 64;
+
+//SVG карты хорошо сжимается, а распаковывается один раз, при первом запросе Map
+std::string CompressMap(const std::string& svg) {
+    std::string compressed;
+    {
+        google::protobuf::io::StringOutputStream string_stream(&compressed);
+        google::protobuf::io::GzipOutputStream::Options options;
+        options.format = google::protobuf::io::GzipOutputStream::ZLIB;
+        google::protobuf::io::GzipOutputStream gzip_stream(&string_stream, options);
+        void* buffer;
+        int size;
+        for (size_t written = 0; written < svg.size(); written += static_cast<size_t>(size)) {
+            if (!gzip_stream.Next(&buffer, &size)) {
+                throw std::runtime_error("Base file: map compression failed");
+            }
+            const size_t part = std::min(static_cast<size_t>(size), svg.size() - written);
+            std::memcpy(buffer, svg.data() + written, part);
+            if (part < static_cast<size_t>(size)) {
+                gzip_stream.BackUp(size - static_cast<int>(part));
+                size = static_cast<int>(part);
+            }
+        }
+        if (!gzip_stream.Close()) {
+            throw std::runtime_error("Base file: map compression failed");
+        }
+    }
+    return compressed;
+}
+
+std::string DecompressMap(const std::string& compressed) {
+    google::protobuf::io::ArrayInputStream array_stream(compressed.data(), static_cast<int>(compressed.size()));
+    google::protobuf::io::GzipInputStream gzip_stream(&array_stream, google::protobuf::io::GzipInputStream::ZLIB);
+    std::string svg;
+    const void* buffer;
+    int size;
+    while (gzip_stream.Next(&buffer, &size)) {
+        svg.append(static_cast<const char*>(buffer), static_cast<size_t>(size));
+    }
+    if (gzip_stream.ZlibErrorCode() < 0) {
+        throw std::runtime_error("Base file: broken rendered map");
+    }
+    return svg;
+}
+
+//add_entry(list, value) добавляет запись в сообщение-список
+template <typename List, typename Container, typename AddEntry>
+void WriteChunked(SectionWriter& writer, transport_catalog_serialize::Section kind,
+                  const Container& container, AddEntry add_entry) {
+    List list;
+    size_t count = 0;
+    for (const auto& value : container) {
+        add_entry(list, value);
+        if (++count == SECTION_CHUNK_SIZE) {
+            writer.Write(kind, list);
+            list.Clear();
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        writer.Write(kind, list);
+    }
+}
+
+void FillStop(transport_catalog_serialize::Stop& stop_out, const Stop& stop) {
+    stop_out.set_name(stop.name);
+    stop_out.set_latitude(stop.coordinates.lat);
+    stop_out.set_longitude(stop.coordinates.lng);
+}
+
+void FillBus(transport_catalog_serialize::Bus& bus_out, const Bus& bus) {
+    bus_out.set_name(bus.name);
+    bus_out.set_is_ring(bus.is_ring);
+    bus_out.mutable_stop()->Add(bus.stops.begin(), bus.stops.end());
+    bus_out.set_unique_stops(bus.unique_stops);
+    bus_out.set_distance(bus.distance);
+    bus_out.set_curvature(bus.curvature);
+}
+
+Bus MakeBus(const transport_catalog_serialize::Bus& bus_in, BusId id) {
+    Bus bus;
+    bus.id = id;
+    bus.name = bus_in.name();
+    bus.stops.assign(bus_in.stop().begin(), bus_in.stop().end());
+    bus.unique_stops = static_cast<int>(bus_in.unique_stops());
+    bus.distance = static_cast<int>(bus_in.distance());
+    bus.curvature = bus_in.curvature();
+    bus.is_ring = bus_in.is_ring();
+    return bus;
+}
+
+transport_catalog_serialize::RoutingSettings MakeRoutingSettings(const router::RoutingSettings& settings) {
+    transport_catalog_serialize::RoutingSettings settings_out;
+    settings_out.set_bus_wait_time(settings.bus_wait_time);
+    settings_out.set_bus_velocity(settings.bus_velocity);
+    return settings_out;
+}
+
+//id родителя из поля parent дельты (id + 1)
+uint32_t ParentId(uint32_t parent, size_t parent_count) {
+    if (parent == 0 || parent > parent_count) {
+        throw std::runtime_error("Delta base: unknown parent id");
+    }
+    return parent - 1;
+}
+
+}//namespace
+
+struct Serializator::ParentBase {
+    explicit ParentBase(const std::filesystem::path& path)
+        :renderer(catalog)
+        ,transport_router(catalog)
+        ,serializator(catalog, renderer, transport_router) {
+        serializator.SetPathToSerialize(path);
+        serializator.Deserialize(true);
+    }
+
+    aggregations::TransportCatalogue catalog;
+    render::MapRenderer renderer;
+    router::TransportRouter transport_router;
+    Serializator serializator;
+};
+
+Serializator::Serializator(aggregations::TransportCatalogue& catalog,
+                           render::MapRenderer& renderer,
+                           router::TransportRouter& router)
+    :catalog_(catalog)
+    ,renderer_(renderer)
+    ,transport_router_(router) {}
+
+Serializator::~Serializator() = default;
+
+void SectionWriter::Write(transport_catalog_serialize::Section kind, const google::protobuf::MessageLite& message) {
+    const uint64_t offset = WriteSection(kind, message);
+    content_hash_ = HashBytes(content_hash_ ^ static_cast<uint64_t>(kind), buffer_.data(), buffer_.size());
+    index_.add_kind(kind);
+    index_.add_offset(offset);
+    index_.add_size(buffer_.size());
+}
+
+uint64_t SectionWriter::WriteSection(transport_catalog_serialize::Section kind, const google::protobuf::MessageLite& message) {
+    //тело собирается в буфере, чтобы посчитать по нему content_hash
+    buffer_.clear();
+    if (message.ByteSizeLong() > static_cast<size_t>(std::numeric_limits<int32_t>::max())
+        || !message.AppendToString(&buffer_)) {
+        throw std::length_error("Base file: section is too large");
+    }
+    const uint32_t size = static_cast<uint32_t>(buffer_.size());
+    coded_.WriteVarint32(static_cast<uint32_t>(kind));
+    coded_.WriteVarint32(size);
+    coded_.WriteRaw(buffer_.data(), static_cast<int>(size));
+    offset_ += google::protobuf::io::CodedOutputStream::VarintSize32(static_cast<uint32_t>(kind))
+             + google::protobuf::io::CodedOutputStream::VarintSize32(size);
+    const uint64_t body_offset = offset_;
+    offset_ += size;
+    return body_offset;
+}
+
+void SectionWriter::Finish() {
+    index_.set_content_hash(content_hash_);
+    const uint64_t offset = WriteSection(transport_catalog_serialize::SECTION_INDEX, index_);
+    coded_.WriteLittleEndian64(offset);
+    coded_.WriteLittleEndian64(buffer_.size());
+    coded_.WriteRaw(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    offset_ += INDEX_TRAILER_SIZE;
+}
+
+SectionReader::SectionReader(const std::filesystem::path& path)
+    :in_(path, std::ios::binary) {
+    if (!in_) {
+        throw std::runtime_error("Base file: can't open "s + path.string());
+    }
+    in_.seekg(0, std::ios::end);
+    const uint64_t file_size = static_cast<uint64_t>(in_.tellg());
+    if (file_size < INDEX_TRAILER_SIZE) {
+        throw std::runtime_error("Base file: no section index");
+    }
+    char trailer[INDEX_TRAILER_SIZE];
+    in_.seekg(static_cast<std::streamoff>(file_size - INDEX_TRAILER_SIZE));
+    in_.read(trailer, sizeof(trailer));
+    if (!in_ || !std::equal(std::begin(INDEX_MAGIC), std::end(INDEX_MAGIC), trailer + 2 * sizeof(uint64_t))) {
+        throw std::runtime_error("Base file: no section index");
+    }
+    Entry index_entry{transport_catalog_serialize::SECTION_INDEX, 0, 0};
+    google::protobuf::io::CodedInputStream::ReadLittleEndian64FromArray(
+            reinterpret_cast<const uint8_t*>(trailer), &index_entry.offset);
+    google::protobuf::io::CodedInputStream::ReadLittleEndian64FromArray(
+            reinterpret_cast<const uint8_t*>(trailer) + sizeof(uint64_t), &index_entry.size);
+    const uint64_t index_end = file_size - INDEX_TRAILER_SIZE;
+    if (index_entry.offset > index_end || index_entry.size != index_end - index_entry.offset) {
+        throw std::runtime_error("Base file: broken section index");
+    }
+    transport_catalog_serialize::SectionIndex index;
+    Read(index_entry, index);
+    content_hash_ = index.content_hash();
+    if (index.offset_size() != index.kind_size() || index.size_size() != index.kind_size()) {
+        throw std::runtime_error("Base file: broken section index");
+    }
+    sections_.reserve(index.kind_size());
+    for (int i = 0; i < index.kind_size(); ++i) {
+        const Entry entry{static_cast<transport_catalog_serialize::Section>(index.kind(i)), index.offset(i), index.size(i)};
+        if (entry.offset > index_entry.offset || entry.size > index_entry.offset - entry.offset) {
+            throw std::runtime_error("Base file: section out of bounds");
+        }
+        sections_.push_back(entry);
+    }
+}
+
+void SectionReader::Read(const Entry& entry, google::protobuf::MessageLite& message) {
+    ReadRange(entry.offset, entry.size, buffer_);
+    if (!message.ParseFromString(buffer_)) {
+        throw std::runtime_error("Base file: broken section");
+    }
+}
+
+void SectionReader::ReadRange(uint64_t offset, uint64_t size, std::string& out) {
+    out.resize(size);
+    in_.clear();
+    in_.seekg(static_cast<std::streamoff>(offset));
+    in_.read(out.data(), static_cast<std::streamsize>(size));
+    if (!in_) {
+        throw std::runtime_error("Base file: truncated section");
+    }
+}
+
 size_t Serializator::Serialize(bool with_graph) const {
-    transport_catalog_serialize::AllData all_data;
-    *all_data.mutable_catalog() = SerializeCatalog();
-    *all_data.mutable_render_settings() = SerializeRenderer();
-    *all_data.mutable_router_data() = SerializeRouter(with_graph);
+    if (format_ == BaseFormat::FLAT) {
+        if (!parent_path_.empty()) {
+            throw std::invalid_argument("Delta base can't be written in the flat format");
+        }
+        flat::WriteBase(path_to_serialize_, catalog_, SerializeRenderer(), renderer_.GetRenderedMap(), transport_router_);
+        return sizeof(path_to_serialize_);
+    }
     std::ofstream out (path_to_serialize_, std::ios::binary | std::ios::trunc);
-    all_data.SerializePartialToOstream(&out);
+    bool written = false;
+    {
+        SectionWriter writer(out);
+        if (parent_path_.empty()) {
+            SerializeCatalog(writer);
+            writer.Write(transport_catalog_serialize::SECTION_RENDER_SETTINGS, SerializeRenderer());
+            writer.Write(transport_catalog_serialize::SECTION_RENDERED_MAP, SerializeRenderedMap());
+            SerializeRouter(writer, with_graph);
+        } else {
+            SerializeDelta(writer);
+        }
+        writer.Finish();
+        written = !writer.HadError();
+    }
+    if (!written || !out.flush()) {
+        throw std::runtime_error("Base file: write failed");
+    }
     return sizeof(path_to_serialize_);
 }
 
 bool Serializator::Deserialize(bool with_graph) {
-    transport_catalog_serialize::AllData all_data;
-    std::ifstream in (path_to_serialize_, std::ios::binary);
-    all_data.ParseFromIstream(&in);
-    DeserializeCatalog(*all_data.mutable_catalog());
-    DeserializeRenderer(*all_data.mutable_render_settings());
-    DeserializeRouter(*all_data.mutable_router_data(), with_graph);
+    if (flat::IsFlatBase(path_to_serialize_)) {
+        transport_catalog_serialize::RenderSettings render_settings;
+        std::string rendered_map;
+        mapped_base_ = flat::ReadBase(path_to_serialize_, catalog_, render_settings, rendered_map, transport_router_,
+                                      content_hash_);
+        DeserializeRenderer(render_settings);
+        renderer_.SetRenderedMap(std::move(rendered_map));
+        return true;
+    }
+    base_reader_ = std::make_unique<SectionReader>(path_to_serialize_);
+    content_hash_ = base_reader_->GetContentHash();
+    with_graph_ = with_graph;
+    renderer_pending_ = true;
+    router_pending_ = true;
+    const std::vector<SectionReader::Entry>& sections = base_reader_->GetSections();
+    if (std::any_of(sections.begin(), sections.end(), [](const SectionReader::Entry& section) {
+            return section.kind == transport_catalog_serialize::SECTION_DELTA_HEADER;})) {
+        DeserializeDeltaCatalog();
+        return true;
+    }
+    //каталог нужен любому запросу, он читается сразу. Тела секций читаются подряд и разбираются
+    //параллельно, а добавляются в каталог в порядке записи: расстояния и автобусы ссылаются на id остановок
+    std::vector<const SectionReader::Entry*> catalog_sections;
+    std::vector<std::unique_ptr<google::protobuf::MessageLite>> messages;
+    for (const SectionReader::Entry& section : sections) {
+        switch (section.kind) {
+        case transport_catalog_serialize::SECTION_STOPS:
+            messages.push_back(std::make_unique<transport_catalog_serialize::StopList>());
+            break;
+        case transport_catalog_serialize::SECTION_DISTANCES:
+            messages.push_back(std::make_unique<transport_catalog_serialize::DistanceList>());
+            break;
+        case transport_catalog_serialize::SECTION_BUSES:
+            messages.push_back(std::make_unique<transport_catalog_serialize::BusList>());
+            break;
+        default:
+            continue;
+        }
+        catalog_sections.push_back(&section);
+    }
+    std::vector<std::string> bodies(catalog_sections.size());
+    for (size_t i = 0; i < catalog_sections.size(); ++i) {
+        base_reader_->ReadRange(catalog_sections[i]->offset, catalog_sections[i]->size, bodies[i]);
+    }
+    parallel::ForEachRange(catalog_sections.size(), 1, [&messages, &bodies](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            if (!messages[i]->ParseFromString(bodies[i])) {
+                throw std::runtime_error("Base file: broken section");
+            }
+        }
+    });
+    for (size_t i = 0; i < catalog_sections.size(); ++i) {
+        switch (catalog_sections[i]->kind) {
+        case transport_catalog_serialize::SECTION_STOPS:
+            DeserializeStops(static_cast<const transport_catalog_serialize::StopList&>(*messages[i]));
+            break;
+        case transport_catalog_serialize::SECTION_DISTANCES:
+            DeserializeDistances(static_cast<const transport_catalog_serialize::DistanceList&>(*messages[i]));
+            break;
+        default:
+            DeserializeBuses(static_cast<const transport_catalog_serialize::BusList&>(*messages[i]));
+        }
+    }
+    catalog_.Freeze(false);
     return true;
 }
 
+bool Serializator::LoadRenderer() {
+    if (!renderer_pending_) {
+        return false;
+    }
+    for (const SectionReader::Entry& section : base_reader_->GetSections()) {
+        if (section.kind == transport_catalog_serialize::SECTION_RENDER_SETTINGS) {
+            transport_catalog_serialize::RenderSettings render_settings;
+            base_reader_->Read(section, render_settings);
+            DeserializeRenderer(render_settings);
+        } else if (section.kind == transport_catalog_serialize::SECTION_RENDERED_MAP) {
+            //без этой секции (база старого формата) карта рисуется при первом запросе
+            transport_catalog_serialize::RenderedMap rendered_map;
+            base_reader_->Read(section, rendered_map);
+            renderer_.SetRenderedMap(rendered_map.compressed() ? DecompressMap(rendered_map.svg())
+                                                               : std::move(*rendered_map.mutable_svg()));
+        }
+    }
+    renderer_pending_ = false;
+    ReleaseBase();
+    return true;
+}
 
-transport_catalog_serialize::Catalog Serializator::SerializeCatalog() const {
-    std::vector<const Stop*> sorted_stops = catalog_.SortStops();
-    //-------buses---------
-    transport_catalog_serialize::BusList bus_list;
-    for (const Bus& bus : catalog_.GetBuses()) {
-        transport_catalog_serialize::Bus bus_to_out;
-        bus_to_out.set_name(bus.name);
-        bus_to_out.set_is_ring(bus.is_ring);
-        if (!bus.stops.empty()) {
-            //если некольцевой маршрут, записывается только половина остановок
-            int stops_count = bus.is_ring ? bus.stops.size() : bus.stops.size() / 2 + 1;
-
-            //список остановок состоит из их порядковых номеров в отсортированном массиве
-            for (int i = 0; i < stops_count; ++i) {
-                const Stop* stop = bus.stops[i];
-                int pos = std::lower_bound(sorted_stops.begin(), sorted_stops.end(),
-                    stop, [](const Stop* lhs, const Stop* rhs) {
-                        return lhs->name < rhs->name; }) - sorted_stops.begin();
-                        bus_to_out.add_stop(pos);
+bool Serializator::LoadRouter() {
+    if (!router_pending_) {
+        return false;
+    }
+    if (parent_) {
+        LoadDeltaRouter();
+        router_pending_ = false;
+        ReleaseBase();
+        return true;
+    }
+    const std::vector<SectionReader::Entry>& sections = base_reader_->GetSections();
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind == transport_catalog_serialize::SECTION_ROUTING_SETTINGS) {
+            transport_catalog_serialize::RoutingSettings settings;
+            base_reader_->Read(section, settings);
+            transport_router_.GetSettingsRef() = { settings.bus_wait_time(), settings.bus_velocity() };
+        }
+    }
+    //рёбра графа разбираются в отдельном потоке одновременно со строками таблицы маршрутов:
+    //таблице нужно только число вершин, а строки пишутся в непересекающиеся части таблицы
+    std::vector<std::string> graph_bodies;
+    std::vector<const SectionReader::Entry*> rows;
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind == transport_catalog_serialize::SECTION_GRAPH && with_graph_) {
+            graph_bodies.emplace_back();
+            base_reader_->ReadRange(section.offset, section.size, graph_bodies.back());
+        } else if (section.kind == transport_catalog_serialize::SECTION_ROUTES_ROW) {
+            if (!rows.empty() && section.offset < rows.back()->offset + rows.back()->size) {
+                throw std::runtime_error("Base file: routes rows out of order");
             }
+            rows.push_back(&section);
         }
-        bus_list.add_bus();
-        *bus_list.mutable_bus(bus_list.bus_size() - 1) = bus_to_out;
     }
-    //--------stops----------
-    transport_catalog_serialize::StopList stop_list;
-    for (const Stop& stop : catalog_.GetStops()) {
-        transport_catalog_serialize::Stop stop_to_out;
-        stop_to_out.set_name(stop.name);
-        stop_to_out.set_latitude(stop.coordinates.lat);
-        stop_to_out.set_longitude(stop.coordinates.lng);
-        stop_list.add_stop();
-        *stop_list.mutable_stop(stop_list.stop_size() - 1) = stop_to_out;
+    if (with_graph_) {
+        transport_router_.GetGraphRef().SetVertexCount(catalog_.GetVertexCount());
+    }
+    else {
+        transport_router_.CreateGraph(false);
+    }
+    transport_router_.GetRouterRef() = std::make_unique<graph::Router<double>>(transport_router_.GetGraphRef(), false);
+    graph::Router<double>& routes = *transport_router_.GetRouterRef();
+    if (rows.size() != routes.GetVertexCount()) {
+        throw std::invalid_argument("Routes data: wrong rows count");
     }
+    std::future<void> graph_loading = std::async(std::launch::async, [this, &graph_bodies]() {
+        transport_catalog_serialize::Graph graph;
+        for (const std::string& body : graph_bodies) {
+            if (!graph.ParseFromString(body)) {
+                throw std::runtime_error("Base file: broken section");
+            }
+            DeserializeGraph(graph);
+        }
+    });
+    //строки читаются блоками подряд идущих секций, каждый блок разбирается параллельно
+    std::string block;
+    for (size_t first = 0; first < rows.size();) {
+        const uint64_t block_begin = rows[first]->offset;
+        size_t last = first + 1;
+        while (last < rows.size() && rows[last]->offset + rows[last]->size - block_begin <= ROWS_BLOCK_SIZE) {
+            ++last;
+        }
+        base_reader_->ReadRange(block_begin, rows[last - 1]->offset + rows[last - 1]->size - block_begin, block);
+        parallel::ForEachRange(last - first, MIN_ROWS_PER_THREAD,
+                               [&rows, &block, &routes, first, block_begin](size_t part_first, size_t part_last) {
+            transport_catalog_serialize::RoutesRow row;
+            for (size_t i = first + part_first; i < first + part_last; ++i) {
+                row.Clear();
+                if (!row.ParseFromArray(block.data() + (rows[i]->offset - block_begin), static_cast<int>(rows[i]->size))) {
+                    throw std::runtime_error("Base file: broken section");
+                }
+                routes.SetDeserializeRow(i, row);
+            }
+        });
+        first = last;
+    }
+    graph_loading.get();
+    router_pending_ = false;
+    ReleaseBase();
+    return true;
+}
+
+bool Serializator::LoadRouteCache() {
+    if (route_cache_path_.empty() || route_cache_size_ == 0) {
+        return false;
+    }
+    std::ifstream in(route_cache_path_, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    //устаревший или повреждённый кэш не ошибка: маршруты просто посчитаются заново
+    transport_catalog_serialize::RouteCache cache;
+    if (!cache.ParseFromIstream(&in) || cache.base_hash() != content_hash_) {
+        return false;
+    }
+    const size_t stop_count = catalog_.GetStops().size();
+    const size_t bus_count = catalog_.GetBuses().size();
+    std::vector<std::optional<router::CompletedRoute>> routes;
+    routes.reserve(cache.route_size());
+    for (const transport_catalog_serialize::CachedRoute& route : cache.route()) {
+        const int line_count = route.stop_size();
+        if (route.from() >= stop_count || route.to() >= stop_count || route.bus_size() != line_count
+            || route.count_size() != line_count || route.wait_time_size() != line_count
+            || route.run_time_size() != line_count) {
+            return false;
+        }
+        if (!route.found()) {
+            routes.emplace_back();
+            continue;
+        }
+        router::CompletedRoute completed{route.total_time(), {}};
+        completed.route.reserve(line_count);
+        for (int i = 0; i < line_count; ++i) {
+            if (route.stop(i) >= stop_count || route.bus(i) >= bus_count) {
+                return false;
+            }
+            completed.route.push_back({&catalog_.GetStop(route.stop(i)), &catalog_.GetBus(route.bus(i)),
+                                       route.wait_time(i), route.run_time(i), route.count(i)});
+        }
+        routes.push_back(std::move(completed));
+    }
+    //обращения прошлых запусков весят вдвое меньше, чтобы кэш забывал маршруты, которые больше не запрашивают
+    router::RouteCache& route_cache = transport_router_.GetCacheRef();
+    for (int i = 0; i < cache.route_size(); ++i) {
+        const transport_catalog_serialize::CachedRoute& route = cache.route(i);
+        route_cache.Add(route.from(), route.to(), std::move(routes[i]), route.hits() / 2);
+    }
+    return true;
+}
+
+bool Serializator::SaveRouteCache() {
+    if (route_cache_path_.empty()) {
+        return false;
+    }
+    transport_catalog_serialize::RouteCache cache;
+    cache.set_base_hash(content_hash_);
+    for (const auto& [stops, entry] : transport_router_.GetCacheRef().GetHottest(route_cache_size_)) {
+        transport_catalog_serialize::CachedRoute& route = *cache.add_route();
+        route.set_from(stops.first);
+        route.set_to(stops.second);
+        route.set_hits(entry->hits);
+        if (!entry->route) {
+            continue;
+        }
+        route.set_found(true);
+        route.set_total_time(entry->route->total_time);
+        for (const router::CompletedRoute::Line& line : entry->route->route) {
+            route.add_stop(line.stop->id);
+            route.add_bus(line.bus->id);
+            route.add_count(line.count_stops);
+            route.add_wait_time(line.wait_time);
+            route.add_run_time(line.run_time);
+        }
+    }
+    //файл заменяется целиком, чтобы одновременно запущенный процесс не прочитал его наполовину записанным
+    std::filesystem::path temp_path = route_cache_path_;
+    temp_path += ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!cache.SerializeToOstream(&out) || !out.flush()) {
+            throw std::runtime_error("Route cache: write failed");
+        }
+    }
+    std::filesystem::rename(temp_path, route_cache_path_);
+    return true;
+}
+
+const std::optional<router::CompletedRoute>& Serializator::FindRoute(StopId from, StopId to) {
+    router::RouteCache& cache = transport_router_.GetCacheRef();
+    if (const std::optional<router::CompletedRoute>* cached = cache.Find(from, to)) {
+        return *cached;
+    }
+    LoadRouter();
+    if (cache.GetCapacity() == 0) {
+        uncached_route_ = transport_router_.ComputeRoute(from, to);
+        return uncached_route_;
+    }
+    return cache.Add(from, to, transport_router_.ComputeRoute(from, to));
+}
+
+
+void Serializator::ReleaseBase() {
+    if (!renderer_pending_ && !router_pending_) {
+        base_reader_.reset();
+    }
+}
+
+
+void Serializator::SerializeCatalog(SectionWriter& writer) const {
+    //--------stops----------
+    WriteChunked<transport_catalog_serialize::StopList>(writer, transport_catalog_serialize::SECTION_STOPS,
+                                                        catalog_.GetStops(),
+                                                        [](auto& stop_list, const Stop& stop) {
+        FillStop(*stop_list.add_stop(), stop);
+    });
     //-------distances--------
-    transport_catalog_serialize::DistanceList distance_list;
-    for (const auto& [key, value] : catalog_.GetDistances()) {
-        transport_catalog_serialize::Distance distance_to_out;
-        int pos = std::lower_bound(sorted_stops.begin(), sorted_stops.end(),
-            key.first, [](const Stop* lhs, const Stop* rhs) {
-                return lhs->name < rhs->name; }) - sorted_stops.begin();
-                distance_to_out.set_index_from(pos);
-                pos = std::lower_bound(sorted_stops.begin(), sorted_stops.end(),
-                    key.second, [](const Stop* lhs, const Stop* rhs) {
-                        return lhs->name < rhs->name; }) - sorted_stops.begin();
-                        distance_to_out.set_index_to(pos);
-                        distance_to_out.set_distance(value);
-                        distance_list.add_distance();
-                        *distance_list.mutable_distance(distance_list.distance_size() - 1) = distance_to_out;
-    }
-    //----------------------
-    transport_catalog_serialize::Catalog catalog;
-    *catalog.mutable_bus_list() = bus_list;
-    *catalog.mutable_stop_list() = stop_list;
-    *catalog.mutable_distance_list() = distance_list;
-    return catalog;
-}
-
-bool Serializator::DeserializeCatalog(transport_catalog_serialize::Catalog& catalog) {
-    //------------stops-----------------
-    transport_catalog_serialize::StopList stop_list = catalog.stop_list();
+    WriteChunked<transport_catalog_serialize::DistanceList>(writer, transport_catalog_serialize::SECTION_DISTANCES,
+                                                            catalog_.GetDistances(),
+                                                            [](auto& distance_list, const auto& distance) {
+        transport_catalog_serialize::Distance& distance_to_out = *distance_list.add_distance();
+        distance_to_out.set_from(distance.first.first);
+        distance_to_out.set_to(distance.first.second);
+        distance_to_out.set_distance(distance.second);
+    });
+    //-------buses---------
+    WriteChunked<transport_catalog_serialize::BusList>(writer, transport_catalog_serialize::SECTION_BUSES,
+                                                       catalog_.GetBuses(),
+                                                       [](auto& bus_list, const Bus& bus) {
+        FillBus(*bus_list.add_bus(), bus);
+    });
+}
+
+bool Serializator::DeserializeStops(const transport_catalog_serialize::StopList& stop_list) {
+    //порядок добавления сохраняет id остановок
     for (int i = 0; i < stop_list.stop_size(); ++i) {
         const transport_catalog_serialize::Stop& stop = stop_list.stop(i);
-        catalog_.AddStop(stop.name(), { stop.latitude(), stop.longitude() });
+        catalog_.AddStop(stop.name(), geo::FixedCoordinates{ stop.latitude(), stop.longitude() });
     }
+    return true;
+}
 
-    std::vector<const Stop*> sorted_stops = catalog_.SortStops();
-    //------------distances-------------
-    transport_catalog_serialize::DistanceList distance_list = catalog.distance_list();
+bool Serializator::DeserializeDistances(const transport_catalog_serialize::DistanceList& distance_list) {
     for (int i = 0; i < distance_list.distance_size(); ++i) {
-        const transport_catalog_serialize::Distance distance = distance_list.distance(i);
-        catalog_.AddDistance(sorted_stops[distance.index_from()]->name, sorted_stops[distance.index_to()]->name, distance.distance());
+        const transport_catalog_serialize::Distance& distance = distance_list.distance(i);
+        catalog_.AddDistance(distance.from(), distance.to(), distance.distance());
     }
-    //-----------buses------------------
-    transport_catalog_serialize::BusList bus_list = catalog.bus_list();
+    return true;
+}
+
+bool Serializator::DeserializeBuses(const transport_catalog_serialize::BusList& bus_list) {
+    //статистика маршрутов копируется из базы, каталог её не пересчитывает
     for (int i = 0; i < bus_list.bus_size(); ++i) {
-        const transport_catalog_serialize::Bus& bus_from_input = bus_list.bus(i);
-        std::vector<std::string_view> stops_in_bus;
-        stops_in_bus.reserve(bus_from_input.stop_size());
-        for (int i = 0; i < bus_from_input.stop_size(); ++i) {
-            stops_in_bus.push_back(sorted_stops[bus_from_input.stop(i)]->name);
-        }
-        catalog_.AddBus(bus_from_input.name(), stops_in_bus, bus_from_input.is_ring());
+        catalog_.AddBus(MakeBus(bus_list.bus(i), static_cast<BusId>(catalog_.GetBuses().size())));
     }
     return true;
 }
@@ -168,9 +660,19 @@ transport_catalog_serialize::RenderSettings Serializator::SerializeRenderer() co
         *settings_to_out.mutable_color_palette(settings_to_out.color_palette_size() - 1) =
             *visit(ColorGetter{}, color);
     }
+    if (settings_.precision != numbers::DEFAULT_PRECISION) {
+        settings_to_out.set_precision(settings_.precision);
+    }
     return settings_to_out;
 }
 
+transport_catalog_serialize::RenderedMap Serializator::SerializeRenderedMap() const {
+    transport_catalog_serialize::RenderedMap rendered_map;
+    rendered_map.set_svg(CompressMap(renderer_.GetRenderedMap()));
+    rendered_map.set_compressed(true);
+    return rendered_map;
+}
+
 bool Serializator::DeserializeRenderer(transport_catalog_serialize::RenderSettings& settings_in) {
     struct ColorGetter {
         Color operator() (transport_catalog_serialize::Color& color) {
@@ -205,61 +707,361 @@ bool Serializator::DeserializeRenderer(transport_catalog_serialize::RenderSettin
     for (int i = 0; i < settings_in.color_palette_size(); ++i) {
         renderer_.GetSettingsRef().color_palette.push_back(ColorGetter()(*settings_in.mutable_color_palette(i)));
     }
+    if (settings_in.has_precision()) {
+        if (!numbers::IsValidPrecision(settings_in.precision())) {
+            throw std::runtime_error("Base file: broken render settings");
+        }
+        renderer_.GetSettingsRef().precision = settings_in.precision();
+    }
     return true;
 }
 
-transport_catalog_serialize::Router Serializator::SerializeRouter(bool with_graph) const {
-    transport_catalog_serialize::Router data_out;
-    transport_catalog_serialize::RoutingSettings settings;
-    settings.set_bus_wait_time(transport_router_.GetSettings().bus_wait_time);
-    settings.set_bus_velocity(transport_router_.GetSettings().bus_velocity);
-    *data_out.mutable_settings() = settings;
-    *data_out.mutable_data() = transport_router_.GetRouter()->GetSerializeData();
-    if (with_graph) {
-        *data_out.mutable_graph() = transport_router_.GetGraph().GetSerializeData();
-        std::vector<std::string_view> buses(catalog_.begin(), catalog_.end());
-        std::vector<std::string_view> stops = catalog_.GetSortedStopsNames();
-        for (const auto& [edge_id, edge_info] : transport_router_.GetEdges()) {
-            transport_catalog_serialize::EdgeInfo info_to_out;
-            auto it_stop = std::lower_bound(stops.begin(), stops.end(),
-                edge_info.stop->name, std::less<>{});
-            info_to_out.set_stop(static_cast<uint32_t>(it_stop - stops.begin()));
-            auto it_bus = std::lower_bound(buses.begin(), buses.end(),
-                edge_info.bus->name, std::less<>{});
-            info_to_out.set_bus(static_cast<uint32_t>(it_bus - buses.begin()));
-            info_to_out.set_count(edge_info.count);
-            (*data_out.mutable_graph()->mutable_info())[edge_id] = info_to_out;
-        }
-    }
-    return data_out;
-}
-
-bool Serializator::DeserializeRouter(transport_catalog_serialize::Router& router_data, bool with_graph) {
-    transport_router_.GetSettingsRef() = { router_data.settings().bus_wait_time(),
-                         router_data.settings().bus_velocity() };
-    const transport_catalog_serialize::Graph& graph = router_data.graph();
+void Serializator::SerializeRouter(SectionWriter& writer, bool with_graph) const {
+    writer.Write(transport_catalog_serialize::SECTION_ROUTING_SETTINGS, MakeRoutingSettings(transport_router_.GetSettings()));
     if (with_graph) {
-        std::vector<std::string_view> buses(catalog_.begin(), catalog_.end());
-        std::vector<std::string_view> stops = catalog_.GetSortedStopsNames();
-        transport_router_.GetGraphRef().SetVertexCount(stops.size());
-        for (int i = 0; i < graph.edges_size(); ++i) {
-            uint32_t edge_id = transport_router_.GetGraphRef().AddEdge({ graph.edges(i).from(),
-                                                 graph.edges(i).to(),
-                                                 graph.edges(i).weight() });
-            const transport_catalog_serialize::EdgeInfo& edge_info = (graph.info().at(edge_id));
-            transport_router_.GetEdgesRef()[edge_id] = { *catalog_.GetStopInfo(stops[edge_info.stop()]),
-                                       *catalog_.GetBusInfo(buses[edge_info.bus()]),
-                                       edge_info.count() };
+        const auto& graph = transport_router_.GetGraph();
+        const auto edges_info = transport_router_.GetEdges();
+        const size_t edge_count = graph.GetEdgeCount();
+        for (graph::EdgeId first = 0; first < edge_count; first += SECTION_CHUNK_SIZE) {
+            const graph::EdgeId last = std::min<graph::EdgeId>(edge_count, first + SECTION_CHUNK_SIZE);
+            transport_catalog_serialize::Graph graph_out = graph.GetSerializeData(first, last);
+            graph_out.mutable_info()->Reserve(static_cast<int>(last - first));
+            for (graph::EdgeId edge_id = first; edge_id < last; ++edge_id) {
+                const router::EdgeInfo& edge_info = edges_info.begin()[edge_id];
+                transport_catalog_serialize::EdgeInfo& info_to_out = *graph_out.add_info();
+                info_to_out.set_stop(edge_info.stop);
+                info_to_out.set_bus(edge_info.bus);
+                info_to_out.set_count(edge_info.count);
+            }
+            writer.Write(transport_catalog_serialize::SECTION_GRAPH, graph_out);
         }
     }
-    else {
-        transport_router_.CreateGraph(false);
+    //строки таблицы маршрутов пишутся по одной, сообщение переиспользуется
+    const graph::Router<double>& routes = *transport_router_.GetRouter();
+    transport_catalog_serialize::RoutesRow row;
+    for (graph::VertexId from = 0; from < routes.GetVertexCount(); ++from) {
+        row.Clear();
+        routes.GetSerializeRow(from, row);
+        writer.Write(transport_catalog_serialize::SECTION_ROUTES_ROW, row);
+    }
+}
+
+bool Serializator::DeserializeGraph(const transport_catalog_serialize::Graph& graph) {
+    if (graph.info_size() != graph.edges_size()) {
+        throw std::invalid_argument("Graph data: edges and info sizes differ");
+    }
+    //номера вершин, остановок и автобусов дальше используются как индексы без проверок, как в flat::ReadBase
+    const size_t vertex_count = transport_router_.GetGraphRef().GetVertexCount();
+    for (int i = 0; i < graph.edges_size(); ++i) {
+        if (graph.edges(i).from() >= vertex_count || graph.edges(i).to() >= vertex_count) {
+            throw std::invalid_argument("Graph data: edge out of graph");
+        }
+        if (graph.info(i).stop() >= catalog_.GetStops().size() || graph.info(i).bus() >= catalog_.GetBuses().size()) {
+            throw std::invalid_argument("Graph data: edge info out of catalog");
+        }
+        transport_router_.GetGraphRef().AddEdge({ graph.edges(i).from(),
+                                                  graph.edges(i).to(),
+                                                  graph.edges(i).weight() });
+        const transport_catalog_serialize::EdgeInfo& edge_info = graph.info(i);
+        transport_router_.GetEdgesRef().push_back({ edge_info.stop(),
+                                                    edge_info.bus(),
+                                                    edge_info.count() });
     }
-    transport_router_.GetRouterRef() = std::make_unique<graph::Router<double>>(transport_router_.GetGraphRef(), router_data.data());
     return true;
 }
 
+void Serializator::SerializeDelta(SectionWriter& writer) const {
+    if (flat::IsFlatBase(parent_path_)) {
+        throw std::invalid_argument("Delta base: parent must be a protobuf base");
+    }
+    ParentBase parent(parent_path_);
+    parent.serializator.LoadRouter();
+    const aggregations::TransportCatalogue& parent_catalog = parent.catalog;
+    const std::vector<uint32_t> stop_to_parent = delta::MatchStops(catalog_, parent_catalog);
+    const std::vector<uint32_t> stop_from_parent = delta::InvertStops(stop_to_parent, parent_catalog.GetStops().size());
 
+    transport_catalog_serialize::DeltaHeader header;
+    header.set_parent(std::filesystem::relative(parent_path_,
+                                                std::filesystem::absolute(path_to_serialize_).parent_path()).generic_string());
+    header.set_parent_hash(parent.serializator.GetContentHash());
+    writer.Write(transport_catalog_serialize::SECTION_DELTA_HEADER, header);
+    //--------stops----------
+    WriteChunked<transport_catalog_serialize::DeltaStopList>(writer, transport_catalog_serialize::SECTION_DELTA_STOPS,
+                                                             catalog_.GetStops(),
+                                                             [&](auto& stop_list, const Stop& stop) {
+        transport_catalog_serialize::DeltaStop& stop_to_out = *stop_list.add_stop();
+        const uint32_t parent_stop = stop_to_parent[stop.id];
+        if (parent_stop != delta::NO_PARENT) {
+            stop_to_out.set_parent(parent_stop + 1);
+            if (parent_catalog.GetStop(parent_stop).coordinates == stop.coordinates) {
+                return;
+            }
+        }
+        FillStop(*stop_to_out.mutable_stop(), stop);
+    });
+    //-------distances--------
+    std::vector<std::pair<std::pair<StopId, StopId>, int>> changed_distances;
+    for (const auto& [key, value] : catalog_.GetDistances()) {
+        const uint32_t from = stop_to_parent[key.first];
+        const uint32_t to = stop_to_parent[key.second];
+        if (from != delta::NO_PARENT && to != delta::NO_PARENT) {
+            auto it = parent_catalog.GetDistances().find({from, to});
+            if (it != parent_catalog.GetDistances().end() && it->second == value) {
+                continue;
+            }
+        }
+        changed_distances.push_back({key, value});
+    }
+    std::vector<std::pair<std::pair<StopId, StopId>, int>> removed_distances;
+    for (const auto& [key, value] : parent_catalog.GetDistances()) {
+        const uint32_t from = stop_from_parent[key.first];
+        const uint32_t to = stop_from_parent[key.second];
+        if (from != delta::NO_PARENT && to != delta::NO_PARENT && !catalog_.GetDistances().count({from, to})) {
+            removed_distances.push_back({key, value});
+        }
+    }
+    auto add_distance = [](auto& distance_list, const auto& distance) {
+        transport_catalog_serialize::Distance& distance_to_out = *distance_list.add_distance();
+        distance_to_out.set_from(distance.first.first);
+        distance_to_out.set_to(distance.first.second);
+        distance_to_out.set_distance(distance.second);
+    };
+    WriteChunked<transport_catalog_serialize::DistanceList>(writer, transport_catalog_serialize::SECTION_DISTANCES,
+                                                            changed_distances, add_distance);
+    WriteChunked<transport_catalog_serialize::DistanceList>(writer, transport_catalog_serialize::SECTION_DELTA_REMOVED_DISTANCES,
+                                                            removed_distances, add_distance);
+    //-------buses---------
+    WriteChunked<transport_catalog_serialize::DeltaBusList>(writer, transport_catalog_serialize::SECTION_DELTA_BUSES,
+                                                            catalog_.GetBuses(),
+                                                            [&](auto& bus_list, const Bus& bus) {
+        transport_catalog_serialize::DeltaBus& bus_to_out = *bus_list.add_bus();
+        if (std::optional<const Bus*> parent_bus = parent_catalog.GetBusInfo(bus.name)) {
+            bus_to_out.set_parent((*parent_bus)->id + 1);
+            if (delta::SameBus(bus, **parent_bus, stop_to_parent)) {
+                return;
+            }
+        }
+        FillBus(*bus_to_out.mutable_bus(), bus);
+    });
+    //-------settings-------
+    writer.Write(transport_catalog_serialize::SECTION_RENDER_SETTINGS, SerializeRenderer());
+    writer.Write(transport_catalog_serialize::SECTION_RENDERED_MAP, SerializeRenderedMap());
+    writer.Write(transport_catalog_serialize::SECTION_ROUTING_SETTINGS, MakeRoutingSettings(transport_router_.GetSettings()));
+    //-------routes---------
+    //в дельту попадают только ячейки, которые не восстанавливаются по родителю в точности,
+    //а если таких больше половины строки или строки у родителя нет - вся строка
+    const std::vector<int32_t> edge_from_parent = delta::MatchEdges(catalog_, transport_router_,
+                                                                    parent.catalog, parent.transport_router,
+                                                                    stop_from_parent);
+    const graph::Router<double>& routes = *transport_router_.GetRouter();
+    const graph::Router<double>& parent_routes = *parent.transport_router.GetRouter();
+    const size_t vertex_count = routes.GetVertexCount();
+    std::vector<char> whole_row(vertex_count, 0);
+    std::vector<std::vector<uint32_t>> changed_cells(vertex_count);
+    parallel::ForEachRange(vertex_count, MIN_ROWS_PER_THREAD, [&](size_t first, size_t last) {
+        std::vector<double> weights(vertex_count);
+        std::vector<int32_t> prev_edges(vertex_count);
+        for (size_t from = first; from < last; ++from) {
+            if (!delta::RemapRow(parent_routes, from, stop_to_parent, edge_from_parent,
+                                 weights.data(), prev_edges.data())) {
+                whole_row[from] = 1;
+                continue;
+            }
+            const double* row_weights = routes.GetWeights() + from * vertex_count;
+            const int32_t* row_prev_edges = routes.GetPrevEdges() + from * vertex_count;
+            std::vector<uint32_t>& cells = changed_cells[from];
+            for (size_t to = 0; to < vertex_count; ++to) {
+                if (prev_edges[to] != row_prev_edges[to] || weights[to] != row_weights[to]) {
+                    cells.push_back(static_cast<uint32_t>(to));
+                }
+            }
+            if (cells.size() > vertex_count / 2) {
+                whole_row[from] = 1;
+                std::vector<uint32_t>().swap(cells);
+            }
+        }
+    });
+    transport_catalog_serialize::DeltaRoutesRow row;
+    for (graph::VertexId from = 0; from < vertex_count; ++from) {
+        if (!whole_row[from] && changed_cells[from].empty()) {
+            continue;
+        }
+        row.Clear();
+        row.set_vertex(static_cast<uint32_t>(from));
+        if (whole_row[from]) {
+            routes.GetSerializeRow(from, *row.mutable_row());
+        } else {
+            const double* row_weights = routes.GetWeights() + from * vertex_count;
+            const int32_t* row_prev_edges = routes.GetPrevEdges() + from * vertex_count;
+            for (uint32_t to : changed_cells[from]) {
+                row.add_column(to);
+                row.add_weight(row_weights[to]);
+                row.add_prev_edge(row_prev_edges[to]);
+            }
+            std::vector<uint32_t>().swap(changed_cells[from]);
+        }
+        writer.Write(transport_catalog_serialize::SECTION_DELTA_ROUTES_ROW, row);
+    }
+}
+
+void Serializator::DeserializeDeltaCatalog() {
+    const std::vector<SectionReader::Entry>& sections = base_reader_->GetSections();
+    transport_catalog_serialize::DeltaHeader header;
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind == transport_catalog_serialize::SECTION_DELTA_HEADER) {
+            base_reader_->Read(section, header);
+        }
+    }
+    //родитель может сам быть дельтой, тогда он так же читает своего родителя
+    parent_ = std::make_unique<ParentBase>(std::filesystem::absolute(path_to_serialize_).parent_path() / header.parent());
+    if (parent_->serializator.GetContentHash() != header.parent_hash()) {
+        throw std::runtime_error("Delta base: parent base "s + header.parent() + " has changed"s);
+    }
+    const aggregations::TransportCatalogue& parent_catalog = parent_->catalog;
+    //------------stops-----------------
+    std::vector<uint32_t> stop_from_parent(parent_catalog.GetStops().size(), delta::NO_PARENT);
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind != transport_catalog_serialize::SECTION_DELTA_STOPS) {
+            continue;
+        }
+        transport_catalog_serialize::DeltaStopList stop_list;
+        base_reader_->Read(section, stop_list);
+        for (const transport_catalog_serialize::DeltaStop& delta_stop : stop_list.stop()) {
+            const transport_catalog_serialize::Stop& stop = delta_stop.stop();
+            if (delta_stop.parent() == 0) {
+                catalog_.AddStop(stop.name(), geo::FixedCoordinates{ stop.latitude(), stop.longitude() });
+                continue;
+            }
+            const Stop& parent_stop = parent_catalog.GetStop(ParentId(delta_stop.parent(), parent_catalog.GetStops().size()));
+            stop_from_parent[parent_stop.id] = static_cast<uint32_t>(catalog_.GetStops().size());
+            catalog_.AddStop(parent_stop.name, delta_stop.has_stop()
+                                               ? geo::FixedCoordinates{ stop.latitude(), stop.longitude() }
+                                               : parent_stop.coordinates);
+        }
+    }
+    //------------distances-------------
+    aggregations::DistancesMap removed;
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind == transport_catalog_serialize::SECTION_DELTA_REMOVED_DISTANCES) {
+            transport_catalog_serialize::DistanceList distance_list;
+            base_reader_->Read(section, distance_list);
+            for (const transport_catalog_serialize::Distance& distance : distance_list.distance()) {
+                removed[{distance.from(), distance.to()}] = static_cast<int>(distance.distance());
+            }
+        }
+    }
+    for (const auto& [key, value] : parent_catalog.GetDistances()) {
+        const uint32_t from = stop_from_parent[key.first];
+        const uint32_t to = stop_from_parent[key.second];
+        if (from != delta::NO_PARENT && to != delta::NO_PARENT && !removed.count(key)) {
+            catalog_.AddDistance(from, to, value);
+        }
+    }
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind == transport_catalog_serialize::SECTION_DISTANCES) {
+            transport_catalog_serialize::DistanceList distance_list;
+            base_reader_->Read(section, distance_list);
+            DeserializeDistances(distance_list);
+        }
+    }
+    //-----------buses------------------
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind != transport_catalog_serialize::SECTION_DELTA_BUSES) {
+            continue;
+        }
+        transport_catalog_serialize::DeltaBusList bus_list;
+        base_reader_->Read(section, bus_list);
+        for (const transport_catalog_serialize::DeltaBus& delta_bus : bus_list.bus()) {
+            const BusId id = static_cast<BusId>(catalog_.GetBuses().size());
+            if (delta_bus.has_bus()) {
+                catalog_.AddBus(MakeBus(delta_bus.bus(), id));
+                continue;
+            }
+            Bus bus = parent_catalog.GetBus(ParentId(delta_bus.parent(), parent_catalog.GetBuses().size()));
+            bus.id = id;
+            for (StopId& stop : bus.stops) {
+                stop = stop_from_parent[stop];
+                if (stop == delta::NO_PARENT) {
+                    throw std::runtime_error("Delta base: unchanged bus "s + bus.name + " lost a stop"s);
+                }
+            }
+            catalog_.AddBus(std::move(bus));
+        }
+    }
+    catalog_.Freeze(false);
+}
+
+void Serializator::LoadDeltaRouter() {
+    const std::vector<SectionReader::Entry>& sections = base_reader_->GetSections();
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind == transport_catalog_serialize::SECTION_ROUTING_SETTINGS) {
+            transport_catalog_serialize::RoutingSettings settings;
+            base_reader_->Read(section, settings);
+            transport_router_.GetSettingsRef() = { settings.bus_wait_time(), settings.bus_velocity() };
+        }
+    }
+    //граф потомка в дельте не хранится: он однозначно строится по каталогу
+    transport_router_.CreateGraph(false);
+    parent_->serializator.LoadRouter();
+    const std::vector<uint32_t> stop_to_parent = delta::MatchStops(catalog_, parent_->catalog);
+    const std::vector<uint32_t> stop_from_parent = delta::InvertStops(stop_to_parent, parent_->catalog.GetStops().size());
+    const std::vector<int32_t> edge_from_parent = delta::MatchEdges(catalog_, transport_router_,
+                                                                    parent_->catalog, parent_->transport_router,
+                                                                    stop_from_parent);
+    transport_router_.GetRouterRef() = std::make_unique<graph::Router<double>>(transport_router_.GetGraphRef(), false);
+    graph::Router<double>& routes = *transport_router_.GetRouterRef();
+    const size_t vertex_count = routes.GetVertexCount();
+    std::vector<char> whole_row(vertex_count, 0);
+    std::vector<transport_catalog_serialize::DeltaRoutesRow> cell_patches;
+    std::vector<int32_t> cell_patch_of_row(vertex_count, -1);
+    transport_catalog_serialize::DeltaRoutesRow row;
+    for (const SectionReader::Entry& section : sections) {
+        if (section.kind != transport_catalog_serialize::SECTION_DELTA_ROUTES_ROW) {
+            continue;
+        }
+        row.Clear();
+        base_reader_->Read(section, row);
+        if (row.vertex() >= vertex_count || row.column_size() != row.weight_size()
+            || row.column_size() != row.prev_edge_size()) {
+            throw std::runtime_error("Delta base: wrong routes row patch");
+        }
+        if (row.has_row()) {
+            routes.SetDeserializeRow(row.vertex(), row.row());
+            whole_row[row.vertex()] = 1;
+        } else {
+            cell_patch_of_row[row.vertex()] = static_cast<int32_t>(cell_patches.size());
+            cell_patches.push_back(std::move(row));
+        }
+    }
+    const graph::Router<double>& parent_routes = *parent_->transport_router.GetRouter();
+    parallel::ForEachRange(vertex_count, MIN_ROWS_PER_THREAD, [&](size_t first, size_t last) {
+        std::vector<double> weights(vertex_count);
+        std::vector<int32_t> prev_edges(vertex_count);
+        for (size_t from = first; from < last; ++from) {
+            if (whole_row[from]) {
+                continue;
+            }
+            bool restored = delta::RemapRow(parent_routes, from, stop_to_parent, edge_from_parent,
+                                            weights.data(), prev_edges.data());
+            if (restored && cell_patch_of_row[from] >= 0) {
+                const transport_catalog_serialize::DeltaRoutesRow& patch = cell_patches[cell_patch_of_row[from]];
+                for (int i = 0; i < patch.column_size(); ++i) {
+                    const uint32_t to = patch.column(i);
+                    if (to >= vertex_count) {
+                        throw std::runtime_error("Delta base: wrong routes row patch");
+                    }
+                    weights[to] = patch.weight(i);
+                    prev_edges[to] = patch.prev_edge(i);
+                }
+            }
+            if (!restored || std::find(prev_edges.begin(), prev_edges.end(), delta::UNRESOLVED) != prev_edges.end()) {
+                throw std::runtime_error("Delta base: routes row can't be restored from the parent");
+            }
+            routes.SetRow(from, weights.data(), prev_edges.data());
+        }
+    });
+    parent_.reset();
+}
 
 }//serialize
 }//tr_cat
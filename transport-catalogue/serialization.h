@@ -7,6 +7,15 @@
 #include "svg.h"
 #include "router.h"
 #include "request_handler.h"
+#include "flat_base.h"
+
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
 
 using namespace std;
 using namespace svg;
@@ -15,32 +24,136 @@ using namespace router;
 namespace tr_cat {
 namespace serialize {
 
+enum class BaseFormat {
+    PROTOBUF,
+    FLAT, //см. flat_base.h
+};
+
+//метка в конце protobuf-базы, после смещения и размера оглавления
+inline constexpr char INDEX_MAGIC[8] = {'T', 'C', 'I', 'N', 'D', 'E', 'X', '1'};
+inline constexpr size_t INDEX_TRAILER_SIZE = 2 * sizeof(uint64_t) + sizeof(INDEX_MAGIC);
+
+//запись секций protobuf-базы (см. Section в transport_catalogue.proto) по мере их построения
+class SectionWriter {
+public:
+    explicit SectionWriter(std::ostream& out)
+        :stream_(&out)
+        ,coded_(&stream_)
+        ,content_hash_(CONTENT_HASH_SEED) {}
+
+    void Write(transport_catalog_serialize::Section kind, const google::protobuf::MessageLite& message);
+    //дописывает оглавление, после этого секции писать нельзя
+    void Finish();
+    bool HadError() {return coded_.HadError();}
+private:
+    google::protobuf::io::OstreamOutputStream stream_;
+    google::protobuf::io::CodedOutputStream coded_;
+    uint64_t offset_ = 0; //ByteCount() у CodedOutputStream - int, для больших файлов считаем сами
+    transport_catalog_serialize::SectionIndex index_;
+    uint64_t content_hash_;
+    std::string buffer_;
+
+    //возвращает смещение тела секции
+    uint64_t WriteSection(transport_catalog_serialize::Section kind, const google::protobuf::MessageLite& message);
+};
+
+//чтение секций protobuf-базы по оглавлению, в любом порядке
+class SectionReader {
+public:
+    struct Entry {
+        transport_catalog_serialize::Section kind;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    explicit SectionReader(const std::filesystem::path& path);
+
+    const std::vector<Entry>& GetSections() const {return sections_;}
+    uint64_t GetContentHash() const {return content_hash_;}
+    void Read(const Entry& entry, google::protobuf::MessageLite& message);
+    //сырые байты [offset, offset + size) для разбора вне потока чтения
+    void ReadRange(uint64_t offset, uint64_t size, std::string& out);
+private:
+    std::ifstream in_;
+    std::vector<Entry> sections_;
+    uint64_t content_hash_ = 0;
+    std::string buffer_;
+};
+
 class Serializator {
 public:
+    //конструктор и деструктор в serialization.cpp, где определён ParentBase
     Serializator (aggregations::TransportCatalogue& catalog,
                   render::MapRenderer& renderer,
-                  router::TransportRouter& router)
-        :catalog_(catalog)
-        ,renderer_(renderer)
-        ,transport_router_(router) {}
+                  router::TransportRouter& router);
+    ~Serializator();
 
     void SetPathToSerialize(const std::filesystem::path& path) {path_to_serialize_= path;}
+    //формат записи, при чтении формат определяется по файлу
+    void SetFormat(BaseFormat format) {format_ = format;}
+    //если задана, Serialize пишет дельту относительно этой базы (см. delta_base.h)
+    void SetParentPath(const std::filesystem::path& path) {parent_path_ = path;}
+    //content_hash прочитанной базы: из оглавления protobuf-базы или заголовка плоской
+    uint64_t GetContentHash() const {return content_hash_;}
     size_t Serialize(bool with_graph = false) const;
+    //из protobuf-базы сразу читается только каталог, настройки карты и маршрутизатор
+    //догружаются при первом обращении через LoadRenderer и LoadRouter
     bool Deserialize(bool with_graph = false);
+    bool LoadRenderer();
+    bool LoadRouter();
+
+    //кэш ответов на запросы маршрутов между запусками process_requests: LoadRouteCache читает
+    //файл, если он посчитан по этой же базе, SaveRouteCache пишет size самых запрашиваемых маршрутов
+    void SetRouteCache(const std::filesystem::path& path, size_t size) {
+        route_cache_path_ = path;
+        route_cache_size_ = size;
+        transport_router_.GetCacheRef().SetCapacity(size);
+    }
+    bool LoadRouteCache();
+    bool SaveRouteCache();
+    //маршрут из кэша; маршрутизатор загружается из базы, только если маршрута в кэше нет.
+    //Ссылка действительна до следующего вызова
+    const std::optional<router::CompletedRoute>& FindRoute(StopId from, StopId to);
 
-    transport_catalog_serialize::Catalog SerializeCatalog() const;
-    bool DeserializeCatalog(transport_catalog_serialize::Catalog& catalog);
+    void SerializeCatalog(SectionWriter& writer) const;
+    bool DeserializeStops(const transport_catalog_serialize::StopList& stop_list);
+    bool DeserializeDistances(const transport_catalog_serialize::DistanceList& distance_list);
+    bool DeserializeBuses(const transport_catalog_serialize::BusList& bus_list);
 
     transport_catalog_serialize::RenderSettings SerializeRenderer() const;
+    transport_catalog_serialize::RenderedMap SerializeRenderedMap() const;
     bool DeserializeRenderer(transport_catalog_serialize::RenderSettings& settings);
 
-    transport_catalog_serialize::Router SerializeRouter(bool with_graph) const;
-    bool DeserializeRouter(transport_catalog_serialize::Router& router_data, bool with_graph);
+    void SerializeRouter(SectionWriter& writer, bool with_graph) const;
+    bool DeserializeGraph(const transport_catalog_serialize::Graph& graph);
 private:
+    //родительская база дельты со своими каталогом и маршрутизатором
+    struct ParentBase;
+
     aggregations::TransportCatalogue& catalog_;
     render::MapRenderer& renderer_;
     router::TransportRouter& transport_router_;
     std::filesystem::path path_to_serialize_;
+    BaseFormat format_ = BaseFormat::PROTOBUF;
+    std::filesystem::path parent_path_;
+    uint64_t content_hash_ = 0;
+    std::unique_ptr<flat::MappedFile> mapped_base_; //на него ссылается transport_router_ после чтения плоской базы
+    //открытая protobuf-база, пока в ней остались непрочитанные секции
+    std::unique_ptr<SectionReader> base_reader_;
+    bool renderer_pending_ = false;
+    bool router_pending_ = false;
+    bool with_graph_ = false;
+    //родитель прочитанной дельты, нужен до загрузки маршрутизатора
+    std::unique_ptr<ParentBase> parent_;
+    std::filesystem::path route_cache_path_;
+    size_t route_cache_size_ = 0;
+    std::optional<router::CompletedRoute> uncached_route_; //ответ FindRoute, если кэш выключен
+
+    void ReleaseBase();
+    //content_hash базы; для плоской считается хэш всего файла, один раз
+    void SerializeDelta(SectionWriter& writer) const;
+    void DeserializeDeltaCatalog();
+    void LoadDeltaRouter();
 };
 
 }//serialize
@@ -53,7 +53,8 @@ struct PrintColor {
         out << "rgb("sv << +color.red << ',' << +color.green << ',' << +color.blue << ')';
     }
     void operator() (Rgba color) {
-        out << "rgba("sv << +color.red << ',' << +color.green << ',' << +color.blue << ',' << color.opacity << ')';
+        out << "rgba("sv << +color.red << ',' << +color.green << ',' << +color.blue << ','
+            << numbers::Double{color.opacity} << ')';
     }
 
 };
@@ -68,7 +69,7 @@ void Object::Render(const RenderContext& context) const {
     // Делегируем вывод тега своим подклассам
     RenderObject(context);
 
-    context.out << std::endl;
+    context.out << '\n';
 }
 
 // ---------- Circle ------------------
@@ -85,9 +86,9 @@ Circle& Circle::SetRadius(double radius)  {
 
 void Circle::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
-    out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-    out << "r=\""sv << radius_ << "\""sv;
-    RenderAttrs(out);
+    out << "<circle cx=\""sv << context.Number(center_.x) << "\" cy=\""sv << context.Number(center_.y) << "\" "sv;
+    out << "r=\""sv << context.Number(radius_) << "\""sv;
+    RenderAttrs(context);
     out << "/>"sv;
 }
 
@@ -108,11 +109,11 @@ void Polyline::RenderObject(const RenderContext& context) const {
         } else {
             is_first = false;
         }
-        out << point.x << ","sv << point.y;
+        out << context.Number(point.x) << ","sv << context.Number(point.y);
     }
     out << "\""sv;
 
-    RenderAttrs(out);
+    RenderAttrs(context);
 
     out << "/>"sv;
 }
@@ -152,9 +153,9 @@ Text& Text::SetData(std::string data) {
 void Text::RenderObject(const RenderContext& context) const {
     auto& out = context.out;
     out << "<text"sv;
-    RenderAttrs(out);
-    out << " x=\""sv << position_.x << "\" y=\""sv << position_.y << "\" dx=\""sv;
-    out << offset_.x << "\" dy=\""sv << offset_.y << "\" font-size=\""sv << font_size_;
+    RenderAttrs(context);
+    out << " x=\""sv << context.Number(position_.x) << "\" y=\""sv << context.Number(position_.y) << "\" dx=\""sv;
+    out << context.Number(offset_.x) << "\" dy=\""sv << context.Number(offset_.y) << "\" font-size=\""sv << font_size_;
     if (!font_family_.empty()) {
         out << "\" font-family=\""sv << font_family_;
     }
@@ -194,10 +195,10 @@ void Document::AddPtr (std::unique_ptr<Object>&& obj) {
     objects_.push_back(move(obj));
 }
 
-void Document::Render(std::ostream& out) const {
-    RenderContext context(out, 1);
-    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+void Document::Render(std::ostream& out, int precision) const {
+    RenderContext context(out, 1, 0, precision);
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
     for (const std::unique_ptr<Object>& obj : objects_) {
         context.Indented().RenderIndent();
         obj->Render(context);
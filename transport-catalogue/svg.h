@@ -1,4 +1,5 @@
 #pragma once
+#include "numbers.h"
 
 #include <cstdint>
 #include <iostream>
@@ -70,14 +71,19 @@ namespace svg {
             : out(out) {
         }
 
-        RenderContext(std::ostream& out, int indent_step, int indent = 0)
+        RenderContext(std::ostream& out, int indent_step, int indent = 0, int precision = numbers::DEFAULT_PRECISION)
             : out(out)
             , indent_step(indent_step)
-            , indent(indent) {
+            , indent(indent)
+            , precision(precision) {
         }
 
         RenderContext Indented() const {
-            return {out, indent_step, indent + indent_step};
+            return {out, indent_step, indent + indent_step, precision};
+        }
+
+        numbers::Double Number(double value) const {
+            return {value, precision};
         }
 
         void RenderIndent() const {
@@ -89,6 +95,7 @@ namespace svg {
         std::ostream& out;
         int indent_step = 0;
         int indent = 0;
+        int precision = numbers::DEFAULT_PRECISION; //значащих цифр в координатах и размерах
     };
 
     class Object {
@@ -130,8 +137,9 @@ namespace svg {
     protected:
         ~PathProps() = default;
 
-        void RenderAttrs(std::ostream& out) const {
+        void RenderAttrs(const RenderContext& context) const {
             using namespace std::literals;
+            std::ostream& out = context.out;
 
             if (fill_color_) {
                 out << " fill=\""sv << *fill_color_ << "\""sv;
@@ -140,7 +148,7 @@ namespace svg {
                 out << " stroke=\""sv << *stroke_color_ << "\""sv;
             }
             if (stroke_width_) {
-                out << " stroke-width=\""sv << *stroke_width_ << "\""sv;
+                out << " stroke-width=\""sv << context.Number(*stroke_width_) << "\""sv;
             }
             if (stroke_linecap_) {
                 out << " stroke-linecap=\""sv << *stroke_linecap_ << "\""sv;
@@ -219,7 +227,7 @@ namespace svg {
     class Document : public ObjectContainer {
     public:
         void AddPtr(std::unique_ptr<Object>&& obj) override;
-        void Render(std::ostream& out) const;
+        void Render(std::ostream& out, int precision = numbers::DEFAULT_PRECISION) const;
 
     private:
         std::vector<std::unique_ptr<Object>> objects_;
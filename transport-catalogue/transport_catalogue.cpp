@@ -4,69 +4,76 @@ namespace tr_cat {
 namespace aggregations {
 
 void TransportCatalogue::AddStop (std::string_view name, geo::Coordinates coords) {
-    stops_data_.push_back({static_cast<std::string>(name), coords,
-                             std::set<std::string_view>{}, vertex_count_++});
-    stops_container_[stops_data_.back().name] = &(stops_data_.back());
+    AddStop(name, geo::FixedCoordinates::FromDegrees(coords));
+}
+
+void TransportCatalogue::AddStop (std::string_view name, geo::FixedCoordinates coords) {
+    Stop& stop = stops_data_.emplace_back();
+    stop.id = static_cast<StopId>(stops_data_.size() - 1);
+    stop.name = static_cast<std::string>(name);
+    stop.coordinates = coords;
+    stop.unit_vector = geo::ToUnitVector(coords.ToDegrees());
+    stops_container_[stop.name] = &stop;
 }
 
 void TransportCatalogue::AddBus (const std::string_view name,
                                  std::vector<std::string_view>& stops, const bool is_ring) {
+    //из названий в идентификаторы существующих остановок
+    std::vector<StopId> stop_ids(stops.size());
+    std::transform(stops.begin(), stops.end(), stop_ids.begin(), [&] (std::string_view element) {
+        return stops_container_.at(element)->id;});
+    AddBus(name, move(stop_ids), is_ring);
+}
 
-    auto it = std::lower_bound(sorted_buses_.begin(), sorted_buses_.end(), name);
-    if (it != sorted_buses_.end() && *it == name) {
-        return;
-    }
-    buses_data_.push_back({static_cast<std::string>(name), {}});
-    sorted_buses_.emplace(it, buses_data_.back().name);
+void TransportCatalogue::AddBus (const std::string_view name,
+                                 std::vector<StopId> stops, const bool is_ring) {
 
-    //добавление к каждой остановке названия этого автобуса
-    for (std::string_view stop : stops) {
-        stops_container_[stop]->buses.insert(buses_data_.back().name);
+    if (buses_container_.count(name)) {
+        return;
     }
-
-    std::vector<Stop*> tmp_stops(stops.size());
-
-    //из названий в указатели на существующие остановки
-    std::transform(stops.begin(), stops.end(), tmp_stops.begin(), [&] (std::string_view element) {
-        return stops_container_[element];});
+    Bus& bus = buses_data_.emplace_back();
+    bus.id = static_cast<BusId>(buses_data_.size() - 1);
+    bus.name = static_cast<std::string>(name);
+    sorted_buses_.push_back(bus.name);
+    buses_container_.insert({bus.name, &bus});
 
     //если остановок нет
-    if (tmp_stops.empty()) {
-        buses_container_.insert({buses_data_.back().name, &(buses_data_.back())});
+    if (stops.empty()) {
         return;
     }
 
-    //запись указателей на уникальные остановки для подсчета
-    std::unordered_set<Stop*>tmp_unique_stops;
-    std::for_each(tmp_stops.begin(), tmp_stops.end(), [&](Stop* element) {
-            tmp_unique_stops.insert(element); });
-    buses_data_.back().unique_stops = static_cast<int>(tmp_unique_stops.size());
+    //подсчет уникальных остановок
+    std::unordered_set<StopId> tmp_unique_stops(stops.begin(), stops.end());
+    bus.unique_stops = static_cast<int>(tmp_unique_stops.size());
+
+    //обратный путь некольцевого маршрута не хранится, его обходит Bus::GetRoute
+    bus.is_ring = is_ring;
+    bus.stops = move(stops);
+}
 
-    //если линейный маршрут, то добавление обратного направления
-    if (!is_ring) {
-        tmp_stops.reserve(tmp_stops.size()*2-1);
-        for (auto it = tmp_stops.end() - 2; it != tmp_stops.begin(); --it) {
-            tmp_stops.push_back(*it);
+void TransportCatalogue::AddBus(Bus bus) {
+    if (bus.id != buses_data_.size()) {
+        throw std::logic_error("Bus id must be equal to its position"s);
+    }
+    if (buses_container_.count(bus.name)) {
+        throw std::invalid_argument("Duplicate bus "s + bus.name);
+    }
+    for (StopId stop : bus.stops) {
+        if (stop >= stops_data_.size()) {
+            throw std::out_of_range("Unknown stop in bus "s + bus.name);
         }
-        tmp_stops.push_back(tmp_stops.front());
-    } else {
-        buses_data_.back().is_ring = true;
     }
-
-    buses_data_.back().stops = move(tmp_stops);
-
-    buses_container_.insert({buses_data_.back().name, &(buses_data_.back())});
-
-    buses_data_.back().distance = ComputeRouteDistance(name);
-    buses_data_.back().curvature = buses_data_.back().distance / ComputeGeoRouteDistance(name);
+    Bus& added = buses_data_.emplace_back(std::move(bus));
+    sorted_buses_.push_back(added.name);
+    buses_container_.insert({added.name, &added});
 }
 
 void TransportCatalogue::AddDistance(const std::string_view lhs_name, const std::string_view rhs_name, double distance) {
+    AddDistance(FindStop(lhs_name)->id, FindStop(rhs_name)->id, static_cast<int>(distance));
+}
 
-    const Stop* lhs = FindStop(lhs_name);
-    const Stop* rhs = FindStop(rhs_name);
-
-    distances_[{lhs, rhs}] = static_cast<int>(distance);
+void TransportCatalogue::AddDistance(StopId lhs, StopId rhs, int distance) {
+    distances_[{lhs, rhs}] = distance;
 }
 
 std::optional<const Bus*> TransportCatalogue::GetBusInfo (std::string_view name) const {
@@ -89,39 +96,137 @@ std::optional<const Stop*> TransportCatalogue::GetStopInfo (std::string_view nam
     return stop;
 }
 
-int TransportCatalogue::GetDistance(const Stop* lhs, const Stop* rhs) const{
+int TransportCatalogue::GetDistance(StopId lhs, StopId rhs) const{
 
-    if (distances_.count ({lhs, rhs})) {
-        return distances_.at({lhs, rhs});
+    if (std::optional<int> distance = FindRoadDistance(lhs, rhs)) {
+        return *distance;
     }
 
-    if (distances_.count ({rhs, lhs})) {
-        return distances_.at({rhs, lhs});
+    return static_cast<int>(ComputeDistance(stops_data_[lhs], stops_data_[rhs]));
+}
+
+void TransportCatalogue::Freeze(bool with_stats) {
+    std::sort(sorted_buses_.begin(), sorted_buses_.end());
+    BuildStopBusIndex();
+    if (with_stats) {
+        ComputeBusesStats();
+    }
+}
+
+void TransportCatalogue::BuildStopBusIndex() {
+    const uint32_t no_bus = std::numeric_limits<uint32_t>::max();
+    std::vector<BusId> buses_by_name;
+    buses_by_name.reserve(sorted_buses_.size());
+    bus_name_rank_.assign(buses_data_.size(), 0);
+    for (std::string_view name : sorted_buses_) {
+        const BusId id = buses_container_.at(name)->id;
+        bus_name_rank_[id] = static_cast<uint32_t>(buses_by_name.size());
+        buses_by_name.push_back(id);
     }
 
-    return static_cast<int>(geo::ComputeDistance(lhs->coordinates, rhs->coordinates));
+    //last_bus[stop] - последний учтённый у остановки автобус, чтобы повторные остановки маршрута считались один раз
+    std::vector<uint32_t> last_bus(stops_data_.size(), no_bus);
+    stop_buses_offsets_.assign(stops_data_.size() + 1, 0);
+    for (BusId bus : buses_by_name) {
+        for (StopId stop : buses_data_[bus].stops) {
+            if (last_bus[stop] != bus) {
+                last_bus[stop] = bus;
+                ++stop_buses_offsets_[stop + 1];
+            }
+        }
+    }
+    for (size_t i = 1; i < stop_buses_offsets_.size(); ++i) {
+        stop_buses_offsets_[i] += stop_buses_offsets_[i - 1];
+    }
+
+    //автобусы обходятся по порядку названий, поэтому списки остановок получаются отсортированными
+    std::vector<uint32_t> fill(stop_buses_offsets_.begin(), stop_buses_offsets_.end() - 1);
+    std::fill(last_bus.begin(), last_bus.end(), no_bus);
+    stop_buses_.assign(stop_buses_offsets_.back(), 0);
+    for (BusId bus : buses_by_name) {
+        for (StopId stop : buses_data_[bus].stops) {
+            if (last_bus[stop] != bus) {
+                last_bus[stop] = bus;
+                stop_buses_[fill[stop]++] = bus;
+            }
+        }
+    }
 }
 
-std::vector<std::string_view> TransportCatalogue::GetSortedStopsNames() const {
-    std::vector<std::string_view> result;
-    result.reserve(stops_data_.size());
-    for (const Stop& stop : stops_data_) {
-        result.emplace_back(stop.name);
+void TransportCatalogue::ComputeBusesStats() {
+    //соседние пары остановок прямого пути всех автобусов считаются одним пакетом,
+    //обратный путь некольцевого маршрута проходит те же пары в обратном порядке
+    size_t pairs_count = 0;
+    for (const Bus& bus : buses_data_) {
+        pairs_count += bus.stops.empty() ? 0 : bus.stops.size() - 1;
     }
-    std::sort(result.begin(), result.end());
+    std::vector<geo::UnitVector> from, to;
+    from.reserve(pairs_count);
+    to.reserve(pairs_count);
+    for (const Bus& bus : buses_data_) {
+        for (size_t i = 1; i < bus.stops.size(); ++i) {
+            from.push_back(stops_data_[bus.stops[i - 1]].unit_vector);
+            to.push_back(stops_data_[bus.stops[i]].unit_vector);
+        }
+    }
+    std::vector<double> geo_distances(pairs_count);
+    geo::ComputeDistances(from.data(), to.data(), geo_distances.data(), pairs_count);
+
+    auto add_pair = [&](StopId lhs, StopId rhs, double geo_distance, int& distance, double& route_geo_distance) {
+        route_geo_distance += geo_distance;
+        if (std::optional<int> road_distance = FindRoadDistance(lhs, rhs)) {
+            distance += *road_distance;
+        } else {
+            distance += static_cast<int>(geo_distance);
+        }
+    };
+
+    const double* bus_geo_distances = geo_distances.data();
+    for (Bus& bus : buses_data_) {
+        const std::vector<StopId>& stops = bus.stops;
+        if (stops.empty()) {
+            continue;
+        }
+        int distance = 0;
+        double route_geo_distance = 0;
+        for (size_t i = 1; i < stops.size(); ++i) {
+            add_pair(stops[i - 1], stops[i], bus_geo_distances[i - 1], distance, route_geo_distance);
+        }
+        if (!bus.is_ring) {
+            for (size_t i = stops.size() - 1; i > 0; --i) {
+                add_pair(stops[i], stops[i - 1], bus_geo_distances[i - 1], distance, route_geo_distance);
+            }
+        }
+        bus_geo_distances += stops.size() - 1;
+        bus.distance = distance;
+        bus.curvature = distance / route_geo_distance;
+    }
+}
+
+TransportCatalogue::BusesRange TransportCatalogue::GetStopBuses(StopId stop) const {
+    return {stop_buses_.begin() + stop_buses_offsets_.at(stop),
+            stop_buses_.begin() + stop_buses_offsets_.at(stop + 1)};
+}
+
+std::vector<BusId> TransportCatalogue::GetCommonBuses(StopId lhs, StopId rhs) const {
+    BusesRange lhs_buses = GetStopBuses(lhs);
+    BusesRange rhs_buses = GetStopBuses(rhs);
+    std::vector<BusId> result;
+    std::set_intersection(lhs_buses.begin(), lhs_buses.end(), rhs_buses.begin(), rhs_buses.end(),
+                          std::back_inserter(result), [this](BusId lhs_bus, BusId rhs_bus) {
+                              return bus_name_rank_[lhs_bus] < bus_name_rank_[rhs_bus];});
     return result;
 }
 
-std::deque<Bus> TransportCatalogue::GetBuses() {
+const std::deque<Bus>& TransportCatalogue::GetBuses() const {
     return buses_data_;
 }
 
-std::deque<Stop> TransportCatalogue::GetStops() {
+const std::deque<Stop>& TransportCatalogue::GetStops() const {
     return stops_data_;
 }
 
-std::unordered_map<std::pair<const Stop*, const Stop*>, int, DistanceHasher, DistanceCompare>
-TransportCatalogue::GetDistances() {
+const DistancesMap& TransportCatalogue::GetDistances() const {
     return distances_;
 }
 
@@ -140,38 +245,14 @@ Bus* TransportCatalogue::FindBus (std:: string_view name) const {
     return buses_container_.at(name);
 }
 
-int TransportCatalogue::ComputeRouteDistance (std::string_view name) const {
-
-    const Bus* bus = FindBus(name);
-    int distance = 0;
-    const std::vector<Stop*>& stops = bus->stops;
-
-    for (size_t i = 1; i < stops.size(); ++i) {
-        distance += GetDistance(stops[i-1], stops[i]);
-    }
-    return distance;
-}
-
-double TransportCatalogue::ComputeGeoRouteDistance (std::string_view name) const {
-    const Bus* bus = FindBus(name);
-    double distance = 0;
-    const std::vector<Stop*>& stops = bus->stops;
-
-    for (size_t i = 1; i < stops.size(); ++i) {
-        distance += geo::ComputeDistance(stops[i-1]->coordinates, stops[i]->coordinates);
+std::optional<int> TransportCatalogue::FindRoadDistance(StopId lhs, StopId rhs) const {
+    if (auto it = distances_.find({lhs, rhs}); it != distances_.end()) {
+        return it->second;
     }
-    return distance;
-}
-
-std::vector<const Stop*> TransportCatalogue::SortStops() const {
-    std::vector<const Stop*>sorted_stops;
-    sorted_stops.reserve(stops_data_.size());
-    for (const Stop& stop : stops_data_) {
-        sorted_stops.push_back(&stop);
+    if (auto it = distances_.find({rhs, lhs}); it != distances_.end()) {
+        return it->second;
     }
-    std::sort(sorted_stops.begin(), sorted_stops.end(),
-              [](const Stop* lhs, const Stop* rhs){return lhs->name < rhs->name;});
-    return sorted_stops;
+    return std::nullopt;
 }
 }//aggregations
 }//tr_cat
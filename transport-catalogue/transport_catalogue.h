@@ -17,6 +17,10 @@
 #include <utility>
 #include <filesystem>
 #include <fstream>
+#include <optional>
+#include <limits>
+#include <iterator>
+#include <stdexcept>
 #include <transport_catalogue.pb.h>
 
 namespace tr_cat {
@@ -25,50 +29,62 @@ using namespace std::string_literals;
 
 class DistanceHasher {
 public:
-    size_t operator() (const std::pair<const Stop*, const Stop*> element) const {
-        const size_t shift = (size_t)log2(1 + sizeof(Stop));
-        const size_t result = (size_t)(element.first) >> shift;
-        return result + ((size_t)(element.second) >> shift) * 37;
-    }
-};
-class DistanceCompare {
-public:
-    bool operator() (const std::pair<const Stop*, const Stop*> lhs, const std::pair<const Stop*, const Stop*> rhs) const {
-        return lhs.first == rhs.first && rhs.second == lhs.second;
+    size_t operator() (const std::pair<StopId, StopId> element) const {
+        return (static_cast<size_t>(element.first) << 32) ^ element.second;
     }
 };
 
+using DistancesMap = std::unordered_map<std::pair<StopId, StopId>, int, DistanceHasher>;
+
 class TransportCatalogue {
 public:
+    using BusesRange = router::ranges::Range<std::vector<BusId>::const_iterator>;
+
     void AddStop (const std::string_view name, geo::Coordinates coords);
+    void AddStop (const std::string_view name, geo::FixedCoordinates coords);
     void AddBus (std::string_view name, std::vector<std::string_view>& stops, const bool is_ring);
+    void AddBus (std::string_view name, std::vector<StopId> stops, const bool is_ring);
+    //готовый автобус из базы: id равен номеру в порядке добавления, unique_stops, distance
+    //и curvature уже посчитаны, поэтому после таких автобусов вызывается Freeze(false)
+    void AddBus (Bus bus);
     void AddDistance(const std::string_view lhs, const std::string_view rhs, double distance);
+    void AddDistance(StopId lhs, StopId rhs, int distance);
     std::optional<const Bus*>  GetBusInfo (std::string_view name) const;
     std::optional<const Stop*> GetStopInfo (std::string_view name) const;
-    int GetDistance(const Stop* lhs, const Stop* rhs) const;
-    size_t GetVertexCount() const {return vertex_count_;}
+    const Stop& GetStop(StopId id) const {return stops_data_[id];}
+    const Bus& GetBus(BusId id) const {return buses_data_[id];}
+    int GetDistance(StopId lhs, StopId rhs) const;
+    //вызывается один раз после добавления всех автобусов: упорядочивает автобусы по названию,
+    //строит индекс автобусов остановок и, если with_stats, считает длину и извилистость маршрутов
+    void Freeze(bool with_stats = true);
+    BusesRange GetStopBuses(StopId stop) const;
+    //автобусы, проходящие через обе остановки, в порядке названий
+    std::vector<BusId> GetCommonBuses(StopId lhs, StopId rhs) const;
+    size_t GetVertexCount() const {return stops_data_.size();}
     auto begin() const {return sorted_buses_.begin();}
     auto end() const {return sorted_buses_.end();}
     size_t size() const {return sorted_buses_.size();}
     size_t empty() const {return sorted_buses_.empty();}
-    std::vector<std::string_view> GetSortedStopsNames() const;
-    std::vector<const Stop*> SortStops() const;
-    std::deque<Bus> GetBuses();
-    std::deque<Stop> GetStops();
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, DistanceHasher, DistanceCompare>
-        GetDistances();
+    const std::deque<Bus>& GetBuses() const;
+    const std::deque<Stop>& GetStops() const;
+    const DistancesMap& GetDistances() const;
 private:
 
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, DistanceHasher, DistanceCompare> distances_;
+    DistancesMap distances_;
     std::deque<Stop> stops_data_;
     std::deque<Bus> buses_data_;
     std::unordered_map<std::string_view, Stop*> stops_container_;
     std::unordered_map<std::string_view, Bus*> buses_container_;
-    std::vector<std::string_view> sorted_buses_;
-    size_t vertex_count_ = 0;
+    std::vector<std::string_view> sorted_buses_; //упорядочиваются в Freeze
+    //CSR-индекс: автобусы остановки stop лежат в stop_buses_[stop_buses_offsets_[stop], stop_buses_offsets_[stop + 1])
+    //и упорядочены по названию, bus_name_rank_[bus] - позиция автобуса в sorted_buses_
+    std::vector<uint32_t> stop_buses_offsets_;
+    std::vector<BusId> stop_buses_;
+    std::vector<uint32_t> bus_name_rank_;
 
-    int ComputeRouteDistance (std::string_view name) const;
-    double ComputeGeoRouteDistance (std::string_view name) const;
+    void BuildStopBusIndex();
+    void ComputeBusesStats();
+    std::optional<int> FindRoadDistance(StopId lhs, StopId rhs) const;
     Stop* FindStop (std::string_view name) const;
     Bus* FindBus (std:: string_view name)const;
 };
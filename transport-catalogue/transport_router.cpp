@@ -1,5 +1,7 @@
 #include "transport_router.h"
 
+#include <algorithm>
+
 namespace tr_cat {
 namespace router {
 
@@ -16,10 +18,14 @@ std::optional<CompletedRoute> TransportRouter::ComputeRoute (graph::VertexId fro
     CompletedRoute result;
     result.total_time = getted_route->weight;
     result.route.reserve(getted_route->edges.size());
+    const ::router::ranges::Range<const EdgeInfo*> edges = GetEdges();
     for (auto& edge : getted_route->edges) {
-        EdgeInfo& info = edges_.at(edge);
-        result.route.push_back(CompletedRoute::Line{info.stop,
-                                                    info.bus,
+        if (edges.begin() + edge >= edges.end()) {
+            throw std::out_of_range("Unknown edge"s);
+        }
+        const EdgeInfo& info = edges.begin()[edge];
+        result.route.push_back(CompletedRoute::Line{&catalog_.GetStop(info.stop),
+                                                    &catalog_.GetBus(info.bus),
                                                     double(routing_settings_.bus_wait_time),
                                                     graph_.GetEdge(edge).weight - routing_settings_.bus_wait_time,
                                                     info.count});
@@ -29,6 +35,72 @@ return result;
 
 }
 
+const std::optional<CompletedRoute>* RouteCache::Find(StopId from, StopId to) {
+    auto it = entries_.find(Key(from, to));
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    ++it->second.hits;
+    return &it->second.route;
+}
+
+const std::optional<CompletedRoute>& RouteCache::Add(StopId from, StopId to, std::optional<CompletedRoute> route,
+                                                    uint64_t hits) {
+    if (capacity_ == 0) {
+        throw std::logic_error("Route cache is disabled"s);
+    }
+    if (entries_.size() >= capacity_ && !entries_.count(Key(from, to))) {
+        EvictColdest();
+    }
+    Entry& entry = entries_[Key(from, to)];
+    entry.route = std::move(route);
+    entry.hits += hits;
+    return entry.route;
+}
+
+void RouteCache::SetCapacity(size_t capacity) {
+    capacity_ = capacity;
+    while (entries_.size() > capacity_) {
+        EvictColdest();
+    }
+}
+
+void RouteCache::EvictColdest() {
+    std::vector<std::pair<uint64_t, uint64_t>> hits; //обращения и ключ
+    hits.reserve(entries_.size());
+    for (const auto& [key, entry] : entries_) {
+        hits.push_back({entry.hits, key});
+    }
+    //четверть сразу, чтобы не перебирать кэш на каждый новый маршрут
+    const size_t target = capacity_ - std::min(capacity_, std::max<size_t>(1, capacity_ / 4));
+    if (hits.size() <= target) {
+        return;
+    }
+    const size_t evict_count = hits.size() - target;
+    std::nth_element(hits.begin(), hits.begin() + evict_count - 1, hits.end());
+    for (size_t i = 0; i < evict_count; ++i) {
+        entries_.erase(hits[i].second);
+    }
+}
+
+std::vector<std::pair<std::pair<StopId, StopId>, const RouteCache::Entry*>> RouteCache::GetHottest(size_t count) const {
+    std::vector<std::pair<std::pair<StopId, StopId>, const Entry*>> result;
+    result.reserve(entries_.size());
+    for (const auto& [key, entry] : entries_) {
+        result.push_back({{static_cast<StopId>(key >> 32), static_cast<StopId>(key)}, &entry});
+    }
+    auto hotter = [](const auto& lhs, const auto& rhs) {
+        return lhs.second->hits != rhs.second->hits ? lhs.second->hits > rhs.second->hits : lhs.first < rhs.first;
+    };
+    if (count < result.size()) {
+        std::partial_sort(result.begin(), result.begin() + count, result.end(), hotter);
+        result.resize(count);
+    } else {
+        std::sort(result.begin(), result.end(), hotter);
+    }
+    return result;
+}
+
 void TransportRouter::CreateGraph(bool create_router) {
 
     if (graph_.GetVertexCount() > 0) {
@@ -40,19 +112,17 @@ void TransportRouter::CreateGraph(bool create_router) {
 
     for (std::string_view bus_name : catalog_) {
         const Bus* bus = *(catalog_.GetBusInfo(bus_name));
-        auto it = bus->stops.begin();
-        if (it == bus->stops.end() || it + 1 == bus->stops.end()) {
+        auto stops = bus->GetRoute();
+        auto it = stops.begin();
+        if (it == stops.end() || it + 1 == stops.end()) {
             continue;
         }
-        for (; it + 1 != bus->stops.end(); ++it) {
+        for (; it + 1 != stops.end(); ++it) {
             double time = double(routing_settings_.bus_wait_time);
-            for (auto next_vertex = it + 1; next_vertex != bus->stops.end(); ++next_vertex) {
-                time += catalog_.GetDistance(*prev(next_vertex), *next_vertex) / bus_velocity;
-                edges_[graph_.AddEdge({ (*it)->vertex_id,
-                                        (*next_vertex)->vertex_id,
-                                        time})] = {*it,
-                                                    bus,
-                                                    static_cast<uint32_t>(next_vertex - it)};
+            for (auto next_vertex = it + 1; next_vertex != stops.end(); ++next_vertex) {
+                time += catalog_.GetDistance(*std::prev(next_vertex), *next_vertex) / bus_velocity;
+                graph_.AddEdge({*it, *next_vertex, time});
+                edges_.push_back({*it, bus->id, static_cast<uint32_t>(next_vertex - it)});
             }
         }
     }
@@ -85,14 +155,23 @@ graph::DirectedWeightedGraph<double>& TransportRouter::GetGraphRef() {
     return graph_;
 }
 
-const std::unordered_map<graph::EdgeId, EdgeInfo>& TransportRouter::GetEdges() {
-    return edges_;
+::router::ranges::Range<const EdgeInfo*> TransportRouter::GetEdges() const {
+    if (edges_view_) {
+        return {edges_view_, edges_view_ + edges_view_size_};
+    }
+    return {edges_.data(), edges_.data() + edges_.size()};
 }
 
-std::unordered_map<graph::EdgeId, EdgeInfo>& TransportRouter::GetEdgesRef() {
+std::vector<EdgeInfo>& TransportRouter::GetEdgesRef() {
     return edges_;
 }
 
+void TransportRouter::AttachEdges(const EdgeInfo* edges, size_t edge_count) {
+    edges_.clear();
+    edges_view_ = edges;
+    edges_view_size_ = edge_count;
+}
+
 } //router
 
 }//tr_cat
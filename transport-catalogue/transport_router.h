@@ -8,6 +8,7 @@
 #include <set>
 #include <exception>
 #include <map>
+#include <unordered_map>
 
 namespace tr_cat {
 
@@ -19,8 +20,8 @@ struct RoutingSettings {
 };
 
 struct EdgeInfo {
-    const Stop* stop;
-    const Bus* bus;
+    StopId stop;
+    BusId bus;
     uint32_t count;
 };
 
@@ -36,6 +37,38 @@ struct CompletedRoute {
     std::vector<Line> route;
 };
 
+//готовые ответы на запросы маршрутов, в том числе об отсутствии маршрута.
+//Самые запрашиваемые сохраняются между запусками process_requests (Serializator::SaveRouteCache).
+//В памяти держится не больше capacity маршрутов: когда места нет, вытесняется четверть
+//наименее запрашиваемых. capacity = 0 - кэш выключен
+class RouteCache {
+public:
+    struct Entry {
+        std::optional<CompletedRoute> route;
+        uint64_t hits = 0;
+    };
+
+    //учитывает обращение; nullptr, если маршрута в кэше нет
+    const std::optional<CompletedRoute>* Find(StopId from, StopId to);
+    const std::optional<CompletedRoute>& Add(StopId from, StopId to, std::optional<CompletedRoute> route,
+                                             uint64_t hits = 1);
+    //не больше count самых запрашиваемых маршрутов, по убыванию числа обращений
+    std::vector<std::pair<std::pair<StopId, StopId>, const Entry*>> GetHottest(size_t count) const;
+    size_t GetSize() const {return entries_.size();}
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const {return capacity_;}
+
+private:
+    static uint64_t Key(StopId from, StopId to) {
+        return (static_cast<uint64_t>(from) << 32) | to;
+    }
+    std::unordered_map<uint64_t, Entry> entries_;
+    size_t capacity_ = 0;
+
+    //освобождает место хотя бы под один маршрут
+    void EvictColdest();
+};
+
 class TransportRouter  {
 public:
 
@@ -51,14 +84,20 @@ public:
     std::unique_ptr<graph::Router<double>>& GetRouterRef();
     const graph::DirectedWeightedGraph<double>& GetGraph();
     graph::DirectedWeightedGraph<double>& GetGraphRef();
-    const std::unordered_map<graph::EdgeId, EdgeInfo>& GetEdges();
-    std::unordered_map<graph::EdgeId, EdgeInfo>& GetEdgesRef();
+    ::router::ranges::Range<const EdgeInfo*> GetEdges() const;
+    std::vector<EdgeInfo>& GetEdgesRef();
+    //информация о рёбрах во внешней памяти (отображённый в память файл базы)
+    void AttachEdges(const EdgeInfo* edges, size_t edge_count);
+    RouteCache& GetCacheRef() {return cache_;}
 private:
     RoutingSettings routing_settings_;
     graph::DirectedWeightedGraph<double> graph_;
     const aggregations::TransportCatalogue& catalog_;
-    std::unordered_map<graph::EdgeId, EdgeInfo> edges_;
+    std::vector<EdgeInfo> edges_; //индекс - EdgeId
+    const EdgeInfo* edges_view_ = nullptr;
+    size_t edges_view_size_ = 0;
     std::unique_ptr<graph::Router<double>> router_;
+    RouteCache cache_;
 };
 
 }//interface